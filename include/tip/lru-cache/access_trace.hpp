@@ -0,0 +1,317 @@
+/*
+ * access_trace.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#ifndef TIP_LRU_CACHE_ACCESS_TRACE_HPP_
+#define TIP_LRU_CACHE_ACCESS_TRACE_HPP_
+
+#include <tip/lru-cache/lru_cache.hpp>
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+namespace tip {
+namespace util {
+
+/**
+ * Header of a binary access trace file. The header is followed by
+ * capacity access_trace_record structures used as a ring buffer,
+ * record number n is stored in slot n % capacity.
+ */
+struct access_trace_header {
+	char				magic[8];
+	std::uint32_t		version;
+	std::uint32_t		record_size;
+	/** Only one of sample_modulus key hashes is recorded */
+	std::uint32_t		sample_modulus;
+	std::uint32_t		reserved;
+	/** Number of record slots in the file */
+	std::uint64_t		capacity;
+	/** Total number of records written */
+	std::uint64_t		written;
+};
+
+struct access_trace_record {
+	std::uint64_t		key_hash;
+	std::uint32_t		event;
+	std::uint32_t		reserved;
+};
+
+namespace detail {
+
+char const access_trace_magic[8] = { 'T', 'I', 'P', 'L', 'R', 'U', 'T', 'R' };
+std::uint32_t const access_trace_version = 1;
+
+/**
+ * Mix bits of a key hash, std::hash for integral types is identity and
+ * cannot be used for sampling as is.
+ */
+inline std::uint64_t
+mix_hash(std::uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+}  // namespace detail
+
+/**
+ * Access recorder writing sampled key hashes to a binary ring file.
+ * Sampling is done by key hash, so all the accesses to a sampled key are
+ * recorded. A cache of capacity C replaying a trace sampled with modulus M
+ * models a cache of capacity C * M.
+ * Recording only appends to a preallocated buffer, records are written to
+ * the file by a background thread every flush interval. When the buffer
+ * is full records are dropped. A write error stops recording, recording
+ * never throws.
+ */
+class access_trace_writer : public access_recorder {
+public:
+	typedef std::mutex						mutex_type;
+	typedef std::lock_guard< mutex_type >	lock_type;
+public:
+	/**
+	 * @param file_name name of the trace file, the file is truncated
+	 * @param capacity maximum number of records kept in the file
+	 * @param sample_modulus record one of sample_modulus keys
+	 * @param buffer_size maximum number of records waiting to be written
+	 * @param flush_ms interval between writes in milliseconds
+	 * @throw std::logic_error if capacity or sample_modulus is zero, the file
+	 * 		is not touched then
+	 * @throw std::runtime_error if the file cannot be opened
+	 */
+	access_trace_writer(std::string const& file_name,
+			std::uint64_t capacity,
+			std::uint32_t sample_modulus = 1,
+			std::size_t buffer_size = 65536,
+			std::uint32_t flush_ms = 100) :
+		flush_interval_(flush_ms ? flush_ms : 1),
+		dropped_(0), failed_(false), stop_(false)
+	{
+		if (capacity == 0 || sample_modulus == 0) {
+			throw std::logic_error("Access trace capacity and sample modulus "
+					"must be positive");
+		}
+		file_.open(file_name.c_str(), std::ios_base::in | std::ios_base::out |
+				std::ios_base::binary | std::ios_base::trunc);
+		if (!file_) {
+			throw std::runtime_error("Failed to open access trace file " + file_name);
+		}
+		std::memset(&header_, 0, sizeof(header_));
+		std::memcpy(header_.magic, detail::access_trace_magic, sizeof(header_.magic));
+		header_.version = detail::access_trace_version;
+		header_.record_size = sizeof(access_trace_record);
+		header_.sample_modulus = sample_modulus;
+		header_.capacity = capacity;
+		write_header();
+		pending_.reserve(buffer_size ? buffer_size : 1);
+		writing_.reserve(pending_.capacity());
+		writer_ = std::thread(&access_trace_writer::run, this);
+	}
+	virtual ~access_trace_writer()
+	{
+		stop_.store(true, std::memory_order_release);
+		writer_.join();
+		flush();
+	}
+
+	virtual void
+	record(std::uint64_t key_hash, access_event event)
+	{
+		if (header_.sample_modulus > 1 &&
+				detail::mix_hash(key_hash) % header_.sample_modulus != 0)
+			return;
+		if (failed_.load(std::memory_order_relaxed))
+			return;
+		lock_type lock(mutex_);
+		if (pending_.size() == pending_.capacity()) {
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		pending_.push_back(access_trace_record{
+			key_hash, static_cast< std::uint32_t >(event), 0 });
+	}
+	/**
+	 * Write buffered records to the file on the calling thread
+	 * @return false if writing to the file failed
+	 */
+	bool
+	flush()
+	{
+		lock_type lock(file_mutex_);
+		{
+			lock_type lock(mutex_);
+			writing_.swap(pending_);
+		}
+		if (!failed_.load(std::memory_order_relaxed)) {
+			try {
+				write_buffer();
+			} catch (...) {
+				failed_.store(true, std::memory_order_relaxed);
+			}
+		}
+		writing_.clear();
+		return !failed();
+	}
+	std::uint32_t
+	sample_modulus() const
+	{
+		return header_.sample_modulus;
+	}
+	/**
+	 * Number of records dropped because the buffer was full
+	 */
+	std::uint64_t
+	dropped() const
+	{
+		return dropped_.load(std::memory_order_relaxed);
+	}
+	/**
+	 * Writing to the file failed, no more records are recorded
+	 */
+	bool
+	failed() const
+	{
+		return failed_.load(std::memory_order_relaxed);
+	}
+private:
+	void
+	run()
+	{
+		std::chrono::milliseconds const slice(
+				std::min< std::uint32_t >(flush_interval_, 10));
+		while (!stop_.load(std::memory_order_acquire)) {
+			std::chrono::milliseconds slept(0);
+			while (slept.count() < flush_interval_ &&
+					!stop_.load(std::memory_order_acquire)) {
+				std::this_thread::sleep_for(slice);
+				slept += slice;
+			}
+			flush();
+		}
+	}
+	void
+	write_header()
+	{
+		file_.seekp(0);
+		file_.write(reinterpret_cast< char const* >(&header_), sizeof(header_));
+	}
+	void
+	write_buffer()
+	{
+		if (writing_.empty())
+			return;
+		std::uint64_t slot = header_.written % header_.capacity;
+		file_.seekp(sizeof(header_) + slot * sizeof(access_trace_record));
+		for (auto const& rec : writing_) {
+			if (slot == header_.capacity) {
+				slot = 0;
+				file_.seekp(sizeof(header_));
+			}
+			file_.write(reinterpret_cast< char const* >(&rec), sizeof(rec));
+			++slot;
+			++header_.written;
+		}
+		write_header();
+		file_.flush();
+		if (!file_) {
+			throw std::runtime_error("Failed to write access trace");
+		}
+	}
+private:
+	mutex_type								mutex_;
+	/** Serializes file access of flush calls */
+	mutex_type								file_mutex_;
+	std::fstream							file_;
+	access_trace_header						header_;
+	std::uint32_t							flush_interval_;
+	/** Records waiting to be written */
+	std::vector< access_trace_record >		pending_;
+	/** Records being written */
+	std::vector< access_trace_record >		writing_;
+	std::atomic< std::uint64_t >			dropped_;
+	std::atomic< bool >						failed_;
+	std::atomic< bool >						stop_;
+	std::thread								writer_;
+};
+
+/**
+ * Reads an access trace file written by access_trace_writer
+ */
+class access_trace_reader {
+public:
+	typedef std::vector< access_trace_record >	record_list;
+public:
+	/**
+	 * @param file_name name of the trace file
+	 * @throw std::runtime_error if the file cannot be read or is not a trace
+	 */
+	explicit
+	access_trace_reader(std::string const& file_name) :
+		file_(file_name.c_str(), std::ios_base::in | std::ios_base::binary)
+	{
+		if (!file_) {
+			throw std::runtime_error("Failed to open access trace file " + file_name);
+		}
+		file_.read(reinterpret_cast< char* >(&header_), sizeof(header_));
+		if (!file_ ||
+				std::memcmp(header_.magic, detail::access_trace_magic,
+						sizeof(header_.magic)) != 0 ||
+				header_.version != detail::access_trace_version ||
+				header_.record_size != sizeof(access_trace_record) ||
+				header_.capacity == 0 || header_.sample_modulus == 0) {
+			throw std::runtime_error(file_name + " is not an access trace file");
+		}
+	}
+
+	access_trace_header const&
+	header() const
+	{
+		return header_;
+	}
+	/**
+	 * Read the records kept in the file, oldest first
+	 */
+	record_list
+	read()
+	{
+		std::uint64_t count = std::min(header_.written, header_.capacity);
+		std::uint64_t first = header_.written > header_.capacity ?
+				header_.written % header_.capacity : 0;
+		record_list records(count);
+		std::uint64_t tail = std::min(count, header_.capacity - first);
+		read_records(first, tail, records.data());
+		read_records(0, count - tail, records.data() + tail);
+		return records;
+	}
+private:
+	void
+	read_records(std::uint64_t slot, std::uint64_t count, access_trace_record* out)
+	{
+		if (!count)
+			return;
+		file_.seekg(sizeof(header_) + slot * sizeof(access_trace_record));
+		file_.read(reinterpret_cast< char* >(out), count * sizeof(access_trace_record));
+		if (!file_) {
+			throw std::runtime_error("Access trace file is truncated");
+		}
+	}
+private:
+	std::ifstream			file_;
+	access_trace_header		header_;
+};
+
+}  // namespace util
+}  // namespace tip
+
+#endif /* TIP_LRU_CACHE_ACCESS_TRACE_HPP_ */
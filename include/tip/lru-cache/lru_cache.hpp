@@ -10,10 +10,19 @@
 
 #include <unordered_map>
 #include <functional>
-#include <list>
+#include <deque>
 #include <mutex>
+#include <thread>
 #include <memory>
 #include <chrono>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <system_error>
+
+#include <pthread.h>
 
 #include <iostream>
 #include <sstream>
@@ -21,6 +30,159 @@
 namespace tip {
 namespace util {
 
+/**
+ * Kind of a cache access reported to an access_recorder
+ */
+enum class access_event : std::uint8_t {
+	hit,
+	miss,
+	put,
+	erase
+};
+
+/**
+ * Interface for recording cache accesses
+ */
+class access_recorder {
+public:
+	virtual ~access_recorder() {}
+	/**
+	 * Record an access to the cache. Can be called concurrently from
+	 * different threads. Is called with the container locked, so it must be
+	 * cheap and must not access the cache. Exceptions are ignored.
+	 * @param key_hash hash of the accessed key
+	 * @param event kind of the access
+	 */
+	virtual void
+	record(std::uint64_t key_hash, access_event event) = 0;
+};
+typedef std::shared_ptr< access_recorder > access_recorder_ptr;
+
+/**
+ * Cache access counters
+ */
+struct cache_stats {
+	std::uint64_t	hits;
+	std::uint64_t	misses;
+	/** Misses on keys recently evicted by shrink */
+	std::uint64_t	ghost_hits;
+	/** Elements evicted by shrink */
+	std::uint64_t	evictions;
+	/** Elements evicted by shrink without a single hit */
+	std::uint64_t	unused_evictions;
+	/** New elements not put because of the admission limit */
+	std::uint64_t	rejections;
+	/** Hits on elements in the tail of the LRU list marked by mark_tail */
+	std::uint64_t	tail_hits;
+};
+
+namespace detail {
+
+/**
+ * Readers-writer lock, writers are preferred to readers where the platform
+ * supports it. Waiting threads block, so long sweeps of the container
+ * holding the lock don't burn the cores of the waiting ones.
+ * The lock is not recursive.
+ */
+class shared_mutex {
+public:
+	shared_mutex()
+	{
+		::pthread_rwlockattr_t attr;
+		::pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+		::pthread_rwlockattr_setkind_np(&attr,
+				PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+		int err = ::pthread_rwlock_init(&rwlock_, &attr);
+		::pthread_rwlockattr_destroy(&attr);
+		if (err) {
+			throw std::system_error(err, std::system_category(),
+					"Failed to initialize readers-writer lock");
+		}
+	}
+	shared_mutex(shared_mutex const&) = delete;
+	shared_mutex&
+	operator = (shared_mutex const&) = delete;
+	~shared_mutex()
+	{
+		::pthread_rwlock_destroy(&rwlock_);
+	}
+
+	void
+	lock()
+	{
+		::pthread_rwlock_wrlock(&rwlock_);
+	}
+	void
+	unlock()
+	{
+		::pthread_rwlock_unlock(&rwlock_);
+	}
+	void
+	lock_shared()
+	{
+		::pthread_rwlock_rdlock(&rwlock_);
+	}
+	void
+	unlock_shared()
+	{
+		::pthread_rwlock_unlock(&rwlock_);
+	}
+private:
+	::pthread_rwlock_t	rwlock_;
+};
+
+/**
+ * Lock guard for shared ownership of a mutex
+ */
+template < typename Mutex >
+class shared_lock_guard {
+public:
+	typedef Mutex	mutex_type;
+public:
+	explicit
+	shared_lock_guard(mutex_type& m) : mutex_(m)
+	{
+		mutex_.lock_shared();
+	}
+	shared_lock_guard(shared_lock_guard const&) = delete;
+	shared_lock_guard&
+	operator = (shared_lock_guard const&) = delete;
+	~shared_lock_guard()
+	{
+		mutex_.unlock_shared();
+	}
+private:
+	mutex_type&		mutex_;
+};
+
+}  // namespace detail
+
+//@{
+/** @name Container locking policies */
+/**
+ * All the operations on the container lock it exclusively.
+ * The mutex is not recursive: an access recorder or a compute function
+ * calling the same cache deadlocks.
+ */
+struct exclusive_locking {
+	typedef std::mutex									mutex_type;
+	typedef std::lock_guard< mutex_type >				lock_type;
+	typedef std::lock_guard< mutex_type >				shared_lock_type;
+};
+/**
+ * Operations that don't modify the container (exists, peek, memory_usage)
+ * take a shared lock and run concurrently with each other. The lock is not
+ * recursive either.
+ */
+struct shared_locking {
+	typedef detail::shared_mutex						mutex_type;
+	typedef std::lock_guard< mutex_type >				lock_type;
+	typedef detail::shared_lock_guard< mutex_type >		shared_lock_type;
+};
+//@}
+
 namespace detail {
 
 //@{
@@ -54,6 +216,11 @@ struct clock_traits< std::chrono::high_resolution_clock > {
 	{
 		return clock_type::now();
 	}
+	static std::int64_t
+	milliseconds(duration_type d)
+	{
+		return std::chrono::duration_cast< std::chrono::milliseconds >(d).count();
+	}
 };
 template < >
 struct time_traits< std::chrono::high_resolution_clock::time_point > {
@@ -73,6 +240,11 @@ struct clock_traits< boost::posix_time::microsec_clock > {
 	{
 		return clock_type::local_time();
 	}
+	static std::int64_t
+	milliseconds(duration_type d)
+	{
+		return d.total_milliseconds();
+	}
 };
 template < >
 struct time_traits< boost::posix_time::ptime > {
@@ -149,10 +321,12 @@ struct time_handling_traits<
 	typedef std::function< void (Value, TimeType) >		set_time_function;
 };
 
-template < typename KeyExtraction, typename TimeHandling >
+template < typename KeyExtraction, typename TimeHandling,
+		typename Locking = exclusive_locking >
 struct cache_types {
 	typedef KeyExtraction								key_extraction_type;
 	typedef TimeHandling								time_handling_type;
+	typedef Locking										locking_type;
 	typedef typename key_extraction_type::key_type		key_type;
 	typedef typename key_extraction_type::value_type	value_type;
 	typedef typename time_handling_type::time_type		time_type;
@@ -161,6 +335,361 @@ struct cache_types {
 			time_handling_type::clock_traits_type		clock_traits_type;
 };
 
+/**
+ * Per-thread direct-mapped front cache slot.
+ * Keeps a copy of the key and value taken from the shared container along
+ * with the container instance and epoch it was copied at.
+ */
+template < typename Key, typename Value >
+struct front_cache_slot {
+	typedef std::pair< Key, Value >					entry_type;
+
+	std::uint64_t									owner;
+	std::uint64_t									epoch;
+	std::size_t										hash;
+	/** Time of the first hit not yet propagated to the container */
+	std::uint32_t									since;
+	/** Hits not yet propagated to the container */
+	std::uint32_t									hits;
+	/** The slot is in the thread's list of slots with pending hits */
+	bool											queued;
+	std::unique_ptr< entry_type >					entry;
+};
+
+/**
+ * Thread-local storage for front cache slots. Slots are shared by all the
+ * container instances with the same key and value types, an owner id
+ * distinguishes entries of different containers.
+ */
+template < typename Key, typename Value >
+struct front_cache {
+	typedef front_cache_slot< Key, Value >			slot_type;
+	typedef std::vector< slot_type >				slot_list;
+	/**
+	 * Slots of a thread and indexes of the slots with hits not yet
+	 * propagated to their containers
+	 */
+	struct local_slots {
+		slot_list									slots;
+		std::vector< std::size_t >					pending;
+	};
+
+	static local_slots&
+	local(std::size_t mask)
+	{
+		static thread_local local_slots local;
+		if (local.slots.size() <= mask)
+			local.slots.resize(mask + 1);
+		return local;
+	}
+	static std::size_t
+	index(std::uint64_t owner, std::size_t hash, std::size_t mask)
+	{
+		return (hash ^ (owner * 0x9e3779b97f4a7c15ULL)) & mask;
+	}
+	/**
+	 * Milliseconds of a monotonic clock, doesn't depend on the cache's clock
+	 */
+	static std::uint32_t
+	now()
+	{
+		return static_cast< std::uint32_t >(
+			std::chrono::duration_cast< std::chrono::milliseconds >(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+	static std::uint64_t
+	next_owner_id()
+	{
+		static std::atomic< std::uint64_t > counter(0);
+		return ++counter;
+	}
+};
+
+/**
+ * Bounded list of hashes of recently evicted keys. A miss on a key in the
+ * ghost list means the key would have been a hit if the cache was bigger
+ * by the ghost list capacity.
+ */
+class ghost_list {
+public:
+	typedef std::uint64_t	hash_type;
+public:
+	ghost_list() : capacity_(0), seq_(0) {}
+
+	std::size_t
+	capacity() const
+	{
+		return capacity_;
+	}
+	void
+	set_capacity(std::size_t capacity)
+	{
+		capacity_ = capacity;
+		while (ring_.size() > capacity_) {
+			pop();
+		}
+	}
+	void
+	push(hash_type hash)
+	{
+		if (!capacity_)
+			return;
+		if (ring_.size() == capacity_)
+			pop();
+		ring_.push_back(hash);
+		index_[hash] = seq_++;
+	}
+	/**
+	 * Check if the hash is in the list and remove it if it is
+	 */
+	bool
+	take(hash_type hash)
+	{
+		return index_.erase(hash) > 0;
+	}
+private:
+	void
+	pop()
+	{
+		auto f = index_.find(ring_.front());
+		if (f != index_.end() && f->second == seq_ - ring_.size())
+			index_.erase(f);
+		ring_.pop_front();
+	}
+private:
+	typedef std::unordered_map< hash_type, std::uint64_t > index_type;
+
+	std::size_t					capacity_;
+	std::uint64_t				seq_;
+	std::deque< hash_type >		ring_;
+	index_type					index_;
+};
+
+/**
+ * Links of a node in a doubly linked list
+ */
+struct list_hook {
+	list_hook*										prev;
+	list_hook*										next;
+};
+
+/**
+ * Circular doubly linked list of nodes derived from list_hook.
+ * The list owns the nodes and deletes them on destruction.
+ */
+template < typename Node >
+class node_list {
+public:
+	typedef Node									node_type;
+public:
+	node_list() : size_(0)
+	{
+		head_.prev = head_.next = &head_;
+	}
+	node_list(node_list const&) = delete;
+	node_list&
+	operator = (node_list const&) = delete;
+	~node_list()
+	{
+		clear();
+	}
+
+	bool
+	empty() const
+	{
+		return size_ == 0;
+	}
+	std::size_t
+	size() const
+	{
+		return size_;
+	}
+	node_type&
+	front()
+	{
+		return *static_cast< node_type* >(head_.next);
+	}
+	node_type&
+	back()
+	{
+		return *static_cast< node_type* >(head_.prev);
+	}
+	void
+	push_front(node_type* node)
+	{
+		link_before(node, head_.next);
+	}
+	void
+	push_back(node_type* node)
+	{
+		link_before(node, &head_);
+	}
+	/**
+	 * Remove the node from the list without deleting it
+	 */
+	void
+	unlink(node_type* node)
+	{
+		node->prev->next = node->next;
+		node->next->prev = node->prev;
+		--size_;
+	}
+	void
+	move_to_front(node_type* node)
+	{
+		if (head_.next != node) {
+			unlink(node);
+			push_front(node);
+		}
+	}
+	void
+	clear()
+	{
+		list_hook* p = head_.next;
+		while (p != &head_) {
+			list_hook* next = p->next;
+			delete static_cast< node_type* >(p);
+			p = next;
+		}
+		head_.prev = head_.next = &head_;
+		size_ = 0;
+	}
+private:
+	void
+	link_before(list_hook* node, list_hook* pos)
+	{
+		node->next = pos;
+		node->prev = pos->prev;
+		pos->prev->next = node;
+		pos->prev = node;
+		++size_;
+	}
+private:
+	list_hook		head_;
+	std::size_t		size_;
+};
+
+/**
+ * Hash index of nodes with chain_next pointer and hash value stored in the
+ * node. Doesn't own the nodes. Removing a node doesn't need it's key, only
+ * the stored hash to find the bucket.
+ */
+template < typename Node >
+class node_index {
+public:
+	typedef Node									node_type;
+public:
+	node_index() : buckets_(initial_buckets, nullptr), bits_(initial_bits), size_(0)
+	{
+	}
+
+	/**
+	 * Find a node with the hash value satisfying the predicate
+	 */
+	template < typename Predicate >
+	node_type*
+	find(std::size_t hash, Predicate pred) const
+	{
+		for (node_type* n = buckets_[bucket(hash)]; n; n = n->chain_next) {
+			if (n->hash == hash && pred(*n))
+				return n;
+		}
+		return nullptr;
+	}
+	void
+	insert(node_type* node)
+	{
+		if (size_ >= buckets_.size())
+			rehash(bits_ + 1);
+		node_type*& head = buckets_[bucket(node->hash)];
+		node->chain_next = head;
+		head = node;
+		++size_;
+	}
+	void
+	remove(node_type* node)
+	{
+		node_type** p = &buckets_[bucket(node->hash)];
+		while (*p != node) {
+			p = &(*p)->chain_next;
+		}
+		*p = node->chain_next;
+		--size_;
+	}
+	std::size_t
+	bucket_count() const
+	{
+		return buckets_.size();
+	}
+private:
+	enum {
+		initial_bits = 4,
+		initial_buckets = 1 << initial_bits
+	};
+	std::size_t
+	bucket(std::size_t hash) const
+	{
+		// Fibonacci hashing, std::hash of integers is identity
+		return static_cast< std::size_t >(
+			(static_cast< std::uint64_t >(hash) * 0x9e3779b97f4a7c15ULL) >> (64 - bits_));
+	}
+	void
+	rehash(unsigned bits)
+	{
+		std::vector< node_type* > old(std::size_t(1) << bits, nullptr);
+		old.swap(buckets_);
+		bits_ = bits;
+		for (node_type* n : old) {
+			while (n) {
+				node_type* next = n->chain_next;
+				node_type*& head = buckets_[bucket(n->hash)];
+				n->chain_next = head;
+				head = n;
+				n = next;
+			}
+		}
+	}
+private:
+	std::vector< node_type* >	buckets_;
+	unsigned					bits_;
+	std::size_t					size_;
+};
+
+/**
+ * Element of the LRU list.
+ * Along with the value holder keeps the key hash, access time as a number
+ * of milliseconds since the container was created (unless the time is kept
+ * in the value) and the generation of the container the element was put at
+ * packed with flag bits. Elements of older generations are treated as
+ * missing and are reclaimed lazily.
+ */
+template < typename ValueHolder >
+struct cache_node : list_hook {
+	enum {
+		generation_bits	= 24,
+		generation_mask	= (1 << generation_bits) - 1,
+		/** The element was accessed after it was put to the cache */
+		flag_referenced	= 1 << generation_bits
+	};
+	cache_node(std::size_t h, std::uint32_t generation, ValueHolder&& vh) :
+		list_hook{ nullptr, nullptr }, chain_next(nullptr),
+		hash(h), access_tick(0), meta(generation), holder(std::move(vh))
+	{
+	}
+
+	cache_node*										chain_next;
+	std::size_t										hash;
+	std::uint32_t									access_tick;
+	std::uint32_t									meta;
+	ValueHolder										holder;
+
+	std::uint32_t
+	generation() const
+	{
+		return meta & generation_mask;
+	}
+};
+
 template < typename CacheTypes, typename ValueHolder >
 class cache_container {
 public:
@@ -171,118 +700,789 @@ public:
 	typedef typename types::time_type					time_type;
 	typedef typename types::duration_type				duration_type;
 	typedef typename types::clock_traits_type			clock_traits_type;
-	typedef std::shared_ptr< value_holder > 			element_type;
+	typedef typename
+			types::key_extraction_type::type			key_intrusive;
+	typedef typename
+			types::time_handling_type::type				time_intrusive;
 protected:
-	typedef std::list< element_type > 					lru_list_type;
-	typedef typename lru_list_type::iterator 			list_iterator;
-	typedef std::unordered_map< key_type, list_iterator> lru_map_type;
-	typedef std::function< key_type(element_type) >		get_key_function;
-	typedef std::function< time_type(element_type) >	get_time_function;
-	typedef std::function<void(element_type, time_type)>set_time_function;
-	typedef std::recursive_mutex						mutex_type;
-	typedef std::lock_guard<mutex_type>					lock_type;
+	typedef cache_node< value_holder >					node_type;
+	typedef node_list< node_type > 						lru_list_type;
+	typedef node_index< node_type >						lru_index_type;
+	typedef std::function< key_type(value_holder const&) >	get_key_function;
+	typedef std::function< time_type(value_holder const&) >	get_time_function;
+	typedef std::function<void(value_holder&, time_type)>	set_time_function;
+	typedef typename types::locking_type				locking_type;
+	typedef typename locking_type::mutex_type			mutex_type;
+	typedef typename locking_type::lock_type			lock_type;
+	typedef typename locking_type::shared_lock_type		shared_lock_type;
+	typedef front_cache< key_type, value_type >			front_cache_type;
+	typedef typename front_cache_type::slot_type		front_slot_type;
+	typedef typename front_cache_type::local_slots		front_local_type;
+	enum {
+		/** Number of stale elements reclaimed by a put */
+		put_reclaim_count = 2,
+		/** Number of stale elements reclaimed per lock acquisition */
+		reclaim_batch_count = 1024
+	};
 public:
-	cache_container()
+	cache_container() : instance_id_(0)
 	{
 		throw std::logic_error("Cache container should be constructed with "
 				"data extraction functions");
 	}
 	cache_container(get_key_function key_fn, get_time_function get_time_fn,
 			set_time_function set_time_fn) :
-				get_key_(key_fn), get_time_(get_time_fn), set_time_(set_time_fn)
+				get_key_(key_fn), get_time_(get_time_fn), set_time_(set_time_fn),
+				start_time_(clock_traits_type::now()),
+				generation_(0), stale_(0), live_(0), recording_(false),
+				hits_(0), misses_(0), ghost_hits_(0), evictions_(0),
+				unused_evictions_(0), rejections_(0), tail_hits_(0),
+				admission_limit_(std::numeric_limits< size_t >::max()),
+				tail_count_(0), tail_tick_(0),
+				instance_id_(front_cache_type::next_owner_id()),
+				epoch_(0), front_mask_(0), front_max_lag_(0), front_refresh_(0)
 	{
 	}
 protected:
-	void
-	put( key_type const& key, element_type elem)
+	/**
+	 * Put an element to the cache, replacing an element with the same key.
+	 * @return false if the element was new and was rejected because the
+	 * 		cache reached it's admission limit
+	 */
+	bool
+	put( key_type const& key, value_holder&& holder)
+	{
+		std::size_t hash = std::hash< key_type >()(key);
+		lru_list_type reclaimed;
+		lock_type lock(mutex_);
+		if (!insert(key, hash, std::move(holder), reclaimed))
+			return false;
+		bump_epoch();
+		return true;
+	}
+	/**
+	 * Apply a function to the value stored under the key in place, with
+	 * the container locked. Counts as a single access to the element.
+	 * The function must not access the cache, the lock is not recursive.
+	 * If the function throws the value is left as the function left it.
+	 * @param key
+	 * @param fn function taking value_type&
+	 * @return false if there is no such key
+	 */
+	template < typename Fn >
+	bool
+	modify(key_type const& key, Fn fn)
 	{
+		std::size_t hash = std::hash< key_type >()(key);
 		lock_type lock(mutex_);
-		erase(key);
-		set_time_(elem, clock_traits_type::now());
-		cache_list_.push_front(elem);
-		cache_map_.insert(std::make_pair(key, cache_list_.begin()));
+		node_type* node = lookup(key, hash);
+		if (!node)
+			return false;
+		bump_epoch();
+		fn(node->holder.value_);
+		return true;
+	}
+	/**
+	 * Apply a function to the value stored under the key in place, with
+	 * the container locked. If there is no such key an element made by
+	 * make_holder is put to the cache, it is subject to the admission limit.
+	 * The function is applied to a new element before it is put, so if the
+	 * function throws the element is not put.
+	 * @param key
+	 * @param fn function taking value_type&
+	 * @param make_holder function returning value_holder for a new element
+	 * @param apply_new apply fn to a new element
+	 * @return false if the new element was rejected
+	 */
+	template < typename Fn, typename MakeHolder >
+	bool
+	modify(key_type const& key, Fn fn, MakeHolder make_holder, bool apply_new)
+	{
+		std::size_t hash = std::hash< key_type >()(key);
+		lru_list_type reclaimed;
+		lock_type lock(mutex_);
+		node_type* node = lookup(key, hash);
+		if (node) {
+			bump_epoch();
+			fn(node->holder.value_);
+			return true;
+		}
+		if (live_.load(std::memory_order_relaxed) >=
+				admission_limit_.load(std::memory_order_relaxed)) {
+			rejections_.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		value_holder holder = make_holder();
+		if (apply_new)
+			fn(holder.value_);
+		if (!insert(key, hash, std::move(holder), reclaimed))
+			return false;
+		bump_epoch();
+		return true;
 	}
 public:
 	void
 	erase(key_type const& key)
 	{
+		std::size_t hash = std::hash< key_type >()(key);
+		lru_list_type reclaimed;
 		lock_type lock(mutex_);
-		auto f = cache_map_.find(key);
-		if (f != cache_map_.end()) {
-			cache_list_.erase(f->second);
-			cache_map_.erase(f);
-		}
+		if (remove(key, hash, reclaimed))
+			bump_epoch();
+		record(hash, access_event::erase);
 	}
+	/**
+	 * Get a value from cache. If the per-thread front cache is enabled it is
+	 * checked first, a hit there doesn't lock the shared container. Front
+	 * cache hits are propagated to the access times and positions in the
+	 * LRU list of the values in batches, see enable_front_cache.
+	 * @param key
+	 * @return copy of the value
+	 * @throw std::range_error if there is no such key in the cache
+	 */
 	value_type
 	get(key_type const& key)
 	{
+		std::size_t mask = front_mask_.load(std::memory_order_relaxed);
+		if (mask) {
+			std::size_t hash = std::hash< key_type >()(key);
+			front_local_type& local = front_cache_type::local(mask);
+			std::size_t idx = front_cache_type::index(instance_id_, hash, mask);
+			front_slot_type& slot = local.slots[idx];
+			if (slot.owner == instance_id_ && slot.entry &&
+					epoch_.load(std::memory_order_acquire) - slot.epoch <=
+						front_max_lag_.load(std::memory_order_relaxed) &&
+					slot.entry->first == key) {
+				record(hash, access_event::hit);
+				std::uint32_t now = front_cache_type::now();
+				if (!slot.hits++) {
+					slot.since = now;
+					if (!slot.queued) {
+						slot.queued = true;
+						local.pending.push_back(idx);
+					}
+				}
+				if (now - slot.since >=
+						front_refresh_.load(std::memory_order_relaxed)) {
+					lock_type lock(mutex_);
+					propagate_front_hits(local);
+				}
+				return slot.entry->second;
+			}
+			lock_type lock(mutex_);
+			propagate_front_hits(local);
+			// Hits of a slot taken over from another container are dropped
+			slot.hits = 0;
+			node_type* p = touch(key, hash);
+			slot.hash = hash;
+			if (slot.entry) {
+				slot.entry->first = key;
+				slot.entry->second = p->holder.value_;
+			} else {
+				slot.entry.reset(
+					new typename front_slot_type::entry_type(key, p->holder.value_));
+			}
+			slot.owner = instance_id_;
+			slot.epoch = epoch_.load(std::memory_order_relaxed);
+			return p->holder.value_;
+		}
+		std::size_t hash = std::hash< key_type >()(key);
+		lock_type lock(mutex_);
+		return touch(key, hash)->holder.value_;
+	}
+	/**
+	 * Evict least recently used elements until there are no more than
+	 * max_size of them.
+	 * @param max_size
+	 * @param max_count maximum number of elements to remove, including the
+	 * 		ones invalidated by clear
+	 * @return number of elements removed
+	 */
+	size_t
+	shrink(size_t max_size, size_t max_count = std::numeric_limits< size_t >::max())
+	{
+		size_t removed = reclaim_batched(max_count);
+		lru_list_type reclaimed;
 		lock_type lock(mutex_);
-		auto f = cache_map_.find(key);
-		if (f == cache_map_.end()) {
-			std::ostringstream os("No key ");
-			os << key << " in cache of " << typeid(value_type).name();
-			throw std::range_error(os.str());
+		while (stale_ == 0 && removed + reclaimed.size() < max_count &&
+				live_.load(std::memory_order_relaxed) > max_size) {
+			node_type* last = &cache_list_.back();
+			if (ghosts_.capacity())
+				ghosts_.push(last->hash);
+			if (!(last->meta & node_type::flag_referenced))
+				unused_evictions_.fetch_add(1, std::memory_order_relaxed);
+			evict(last, reclaimed);
+			evictions_.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (!reclaimed.empty())
+			bump_epoch();
+		return removed + reclaimed.size();
+	}
+	/**
+	 * Remove elements that were not accessed for longer than age.
+	 * @param age
+	 * @param max_count maximum number of elements to remove, including the
+	 * 		ones invalidated by clear
+	 * @return number of elements removed
+	 */
+	size_t
+	expire(duration_type age, size_t max_count = std::numeric_limits< size_t >::max())
+	{
+		size_t removed = reclaim_batched(max_count);
+		lru_list_type reclaimed;
+		lock_type lock(mutex_);
+		time_type now = clock_traits_type::now();
+		while (stale_ == 0 && removed + reclaimed.size() < max_count &&
+				!cache_list_.empty() &&
+				is_expired(cache_list_.back(), now, age, time_intrusive{})) {
+			evict(&cache_list_.back(), reclaimed);
 		}
-		cache_list_.splice(cache_list_.begin(), cache_list_, f->second);
-		set_time_(*f->second, clock_traits_type::now());
-		return (*f->second)->value_;
+		if (!reclaimed.empty())
+			bump_epoch();
+		return removed + reclaimed.size();
 	}
+	/**
+	 * Invalidate all the elements in the cache. Takes constant time, the
+	 * elements are treated as missing and are reclaimed later by put,
+	 * shrink, expire or reclaim calls. Those release the lock every
+	 * reclaim_batch_count reclaimed elements.
+	 */
 	void
-	shrink(size_t max_size)
+	clear()
 	{
+		lru_list_type reclaimed;
 		lock_type lock(mutex_);
-		while (cache_list_.size() > max_size) {
-			auto last = cache_list_.end();
-			--last;
-			cache_map_.erase(get_key_(*last));
-			cache_list_.pop_back();
+		if (((generation_ + 1) & node_type::generation_mask) == 0) {
+			// Generation counter wraps, elements of the previous generation
+			// zero must not come to life
+			reclaim_stale(stale_, reclaimed);
 		}
+		generation_ = (generation_ + 1) & node_type::generation_mask;
+		stale_ = cache_list_.size();
+		live_.store(0, std::memory_order_relaxed);
+		bump_epoch();
+	}
+	/**
+	 * Destroy elements invalidated by clear.
+	 * The elements are destroyed after the container's lock is released.
+	 * @param max_count maximum number of elements to reclaim
+	 * @return number of elements reclaimed
+	 */
+	size_t
+	reclaim(size_t max_count = std::numeric_limits< size_t >::max())
+	{
+		return reclaim_batched(max_count);
 	}
+	/**
+	 * Set capacity of the list of keys evicted by shrink. Misses on those
+	 * keys are counted as ghost hits. Zero capacity disables tracking.
+	 */
 	void
-	expire(duration_type age)
+	set_ghost_capacity(size_t capacity)
 	{
 		lock_type lock(mutex_);
-		time_type now = clock_traits_type::now();
-		time_type eldest = now - age;
-		for (auto p = cache_list_.rbegin();
-				p != cache_list_.rend() && get_time_(*p) < eldest;) {
-			cache_map_.erase(get_key_(*p));
-			cache_list_.pop_back();
+		ghosts_.set_capacity(capacity);
+	}
+	size_t
+	ghost_capacity() const
+	{
+		shared_lock_type lock(mutex_);
+		return ghosts_.capacity();
+	}
+	/**
+	 * Access counters. Front cache hits are counted in the thread's slots
+	 * and are added when the thread propagates them to the container, so
+	 * the hits counter lags behind.
+	 */
+	cache_stats
+	stats() const
+	{
+		return cache_stats{
+			hits_.load(std::memory_order_relaxed),
+			misses_.load(std::memory_order_relaxed),
+			ghost_hits_.load(std::memory_order_relaxed),
+			evictions_.load(std::memory_order_relaxed),
+			unused_evictions_.load(std::memory_order_relaxed),
+			rejections_.load(std::memory_order_relaxed),
+			tail_hits_.load(std::memory_order_relaxed)
+		};
+	}
+	/**
+	 * Mark count least recently used elements as the tail of the LRU list.
+	 * Until the next call hits on the elements that were in the tail are
+	 * counted as tail hits, i.e. the hits the cache would lose if it was
+	 * smaller by count elements. The elements are told by their access
+	 * time. The marking is not changed while there are elements invalidated
+	 * by clear and not yet reclaimed. Zero count stops counting.
+	 * @param count number of elements in the tail
+	 * @return number of elements in the marked tail
+	 */
+	size_t
+	mark_tail(size_t count)
+	{
+		lock_type lock(mutex_);
+		if (stale_)
+			return tail_count_;
+		tail_count_ = std::min(count, cache_list_.size());
+		if (tail_count_) {
+			list_hook* node = &cache_list_.back();
+			for (size_t i = 1; i < tail_count_; ++i) {
+				node = node->prev;
+			}
+			tail_tick_ = access_ticks(*static_cast< node_type* >(node));
 		}
+		return tail_count_;
 	}
+	/**
+	 * Limit the number of elements the cache admits. When the cache holds
+	 * max_size elements or more, puts of new keys are rejected, existing
+	 * keys are still updated. The cache is not shrunk.
+	 * @param max_size
+	 */
 	void
-	clear()
+	set_admission_limit(size_t max_size)
+	{
+		admission_limit_.store(max_size, std::memory_order_relaxed);
+	}
+	size_t
+	admission_limit() const
 	{
+		return admission_limit_.load(std::memory_order_relaxed);
+	}
+	/**
+	 * Estimated number of bytes used by an element of the cache
+	 */
+	static size_t
+	entry_size()
+	{
+		// node and an index bucket
+		return sizeof(node_type) + sizeof(node_type*);
+	}
+	/**
+	 * Number of bytes used by the elements, including the ones invalidated
+	 * by clear and not yet reclaimed, and the index
+	 */
+	size_t
+	memory_usage() const
+	{
+		shared_lock_type lock(mutex_);
+		return cache_list_.size() * sizeof(node_type) +
+				index_.bucket_count() * sizeof(node_type*);
+	}
+	/**
+	 * Set a recorder for cache accesses. Pass an empty pointer to stop
+	 * recording.
+	 */
+	void
+	set_access_recorder(access_recorder_ptr recorder)
+	{
+		lock_type lock(mutex_);
+		std::atomic_store(&recorder_, recorder);
+		recording_.store(static_cast< bool >(recorder), std::memory_order_release);
+	}
+	/**
+	 * Enable per-thread front cache for get operations.
+	 * Every mutation of the container (put, erase, clear, evictions) advances
+	 * the container's epoch, a front cache entry is used only while the epoch
+	 * didn't advance more than max_lag times since the entry was filled.
+	 * With max_lag of zero reads are never stale, but a mutation of any
+	 * element invalidates front cache entries of all the threads, so under
+	 * write traffic the front cache seldom hits unless max_lag is raised.
+	 * Front cache hits are queued per thread. When a queued hit becomes
+	 * older than the refresh interval, or the thread locks the container on
+	 * a front cache miss, all the queued hits of the thread are propagated
+	 * under a single lock: the elements are moved to the head of the LRU
+	 * list and their access times are updated, so elements read through the
+	 * front cache are not expired or evicted as unused. A thread locks the
+	 * container for that at most once per refresh interval. The interval is
+	 * measured by a monotonic clock, not by the cache's clock.
+	 * Values copied to the front cache live until they are replaced in the
+	 * slot or the thread exits.
+	 * @param slots number of slots per thread, rounded up to a power of two
+	 * @param max_lag maximum number of mutations a front cache entry can lag
+	 * @param refresh_ms front cache refresh interval in milliseconds
+	 */
+	void
+	enable_front_cache(std::size_t slots, std::uint64_t max_lag = 0,
+			std::uint32_t refresh_ms = 10)
+	{
+		std::size_t size = 2;
+		while (size < slots)
+			size <<= 1;
 		lock_type lock(mutex_);
-		cache_list_.clear();
-		cache_map_.clear();
+		front_max_lag_.store(max_lag, std::memory_order_relaxed);
+		front_refresh_.store(refresh_ms, std::memory_order_relaxed);
+		front_mask_.store(slots ? size - 1 : 0, std::memory_order_relaxed);
+		bump_epoch();
+	}
+	void
+	disable_front_cache()
+	{
+		enable_front_cache(0);
 	}
 	bool
 	exists(key_type const& key) const
 	{
-		lock_type lock(mutex_);
-		return cache_map_.find(key) != cache_map_.end();
+		std::size_t hash = std::hash< key_type >()(key);
+		shared_lock_type lock(mutex_);
+		node_type* node = find(key, hash);
+		return node && !is_stale(*node);
+	}
+	/**
+	 * Get a value from cache without updating it's access time and position
+	 * in the LRU list. Is not counted in the cache statistics.
+	 * @param key
+	 * @return copy of the value
+	 * @throw std::range_error if there is no such key in the cache
+	 */
+	value_type
+	peek(key_type const& key) const
+	{
+		std::size_t hash = std::hash< key_type >()(key);
+		shared_lock_type lock(mutex_);
+		node_type* node = find(key, hash);
+		if (!node || is_stale(*node))
+			throw_missing(key);
+		return node->holder.value_;
 	}
 	bool
 	empty() const
 	{
-		lock_type lock(mutex_);
-		return cache_list_.empty();
+		return size() == 0;
 	}
+	/**
+	 * Number of valid elements in the cache. Doesn't lock the container.
+	 */
 	size_t
 	size() const
 	{
-		lock_type lock(mutex_);
-		return cache_list_.size();
+		return live_.load(std::memory_order_relaxed);
+	}
+private:
+	bool
+	is_stale(node_type const& node) const
+	{
+		return node.generation() != generation_;
+	}
+	std::uint32_t
+	ticks(time_type tm) const
+	{
+		return static_cast< std::uint32_t >(
+				clock_traits_type::milliseconds(tm - start_time_));
+	}
+	void
+	set_access_time(node_type& node, time_type now)
+	{
+		set_access_time(node, now, time_intrusive{});
+	}
+	std::uint32_t
+	access_ticks(node_type const& node) const
+	{
+		return access_ticks(node, time_intrusive{});
+	}
+	std::uint32_t
+	access_ticks(node_type const& node, non_intrusive const&) const
+	{
+		return node.access_tick;
+	}
+	std::uint32_t
+	access_ticks(node_type const& node, intrusive const&) const
+	{
+		return ticks(get_time_(node.holder));
+	}
+	/**
+	 * Count a hit on the element if it was in the marked tail, must be
+	 * called before the element's access time is updated
+	 */
+	void
+	count_tail_hit(node_type const& node)
+	{
+		if (tail_count_ &&
+				static_cast< std::int32_t >(tail_tick_ - access_ticks(node)) >= 0)
+			tail_hits_.fetch_add(1, std::memory_order_relaxed);
+	}
+	void
+	set_access_time(node_type& node, time_type now, non_intrusive const&)
+	{
+		node.access_tick = ticks(now);
+	}
+	void
+	set_access_time(node_type& node, time_type now, intrusive const&)
+	{
+		set_time_(node.holder, now);
+	}
+	/**
+	 * Check the element was not accessed for longer than age. Tick
+	 * difference is computed modulo 2^32, so elements not accessed for more
+	 * than 49 days look younger than they are.
+	 */
+	bool
+	is_expired(node_type const& node, time_type now, duration_type age,
+			non_intrusive const&) const
+	{
+		std::int64_t age_ms = clock_traits_type::milliseconds(age);
+		if (age_ms > std::numeric_limits< std::uint32_t >::max())
+			return false;
+		std::uint32_t elapsed = ticks(now) - node.access_tick;
+		return age_ms < 0 || elapsed > static_cast< std::uint32_t >(age_ms);
+	}
+	bool
+	is_expired(node_type const& node, time_type now, duration_type age,
+			intrusive const&) const
+	{
+		return get_time_(node.holder) < now - age;
+	}
+	bool
+	key_equals(node_type const& node, key_type const& key,
+			non_intrusive const&) const
+	{
+		return node.holder.key_ == key;
+	}
+	bool
+	key_equals(node_type const& node, key_type const& key,
+			intrusive const&) const
+	{
+		return get_key_(node.holder) == key;
+	}
+	node_type*
+	find(key_type const& key, std::size_t hash) const
+	{
+		return index_.find(hash,
+			[this, &key](node_type const& node)
+			{ return key_equals(node, key, key_intrusive{}); });
+	}
+	/**
+	 * Unlink the element from the index and move it to the reclaimed list.
+	 * Doesn't need the element's key.
+	 */
+	void
+	evict(node_type* node, lru_list_type& reclaimed)
+	{
+		if (is_stale(*node))
+			--stale_;
+		else
+			live_.fetch_sub(1, std::memory_order_relaxed);
+		index_.remove(node);
+		cache_list_.unlink(node);
+		reclaimed.push_back(node);
+	}
+	/**
+	 * Remove the element from the container without advancing the epoch.
+	 * The element is moved to the reclaimed list.
+	 * Must be called with the mutex locked.
+	 * @return true if a valid element was removed
+	 */
+	bool
+	remove(key_type const& key, std::size_t hash, lru_list_type& reclaimed)
+	{
+		node_type* node = find(key, hash);
+		if (node) {
+			bool stale = is_stale(*node);
+			evict(node, reclaimed);
+			return !stale;
+		}
+		return false;
+	}
+	/**
+	 * Move stale elements to the reclaimed list. Stale elements are never
+	 * moved to the head of the LRU list, so they always form it's tail.
+	 * Must be called with the mutex locked.
+	 */
+	void
+	reclaim_stale(size_t max_count, lru_list_type& reclaimed)
+	{
+		for (; stale_ > 0 && max_count > 0; --max_count) {
+			evict(&cache_list_.back(), reclaimed);
+		}
+	}
+	/**
+	 * Move stale elements to a reclaimed list and destroy them in batches of
+	 * reclaim_batch_count, the lock is released between the batches so a
+	 * sweep after clear of a big cache doesn't stall other operations.
+	 * @return number of elements reclaimed
+	 */
+	size_t
+	reclaim_batched(size_t max_count)
+	{
+		size_t count = 0;
+		while (count < max_count) {
+			lru_list_type reclaimed;
+			lock_type lock(mutex_);
+			if (stale_ == 0)
+				break;
+			reclaim_stale(std::min< size_t >(max_count - count,
+					reclaim_batch_count), reclaimed);
+			count += reclaimed.size();
+		}
+		return count;
+	}
+	/**
+	 * Put a new element to the head of the LRU list, replacing an element
+	 * with the same key. Doesn't advance the epoch.
+	 * Must be called with the mutex locked.
+	 * @return the new element or nullptr if it was rejected because of the
+	 * 		admission limit
+	 */
+	node_type*
+	insert(key_type const& key, std::size_t hash, value_holder&& holder,
+			lru_list_type& reclaimed)
+	{
+		std::unique_ptr< node_type > node(
+				new node_type(hash, generation_, std::move(holder)));
+		if (!remove(key, hash, reclaimed) &&
+				live_.load(std::memory_order_relaxed) >=
+					admission_limit_.load(std::memory_order_relaxed)) {
+			rejections_.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		set_access_time(*node, clock_traits_type::now());
+		index_.insert(node.get());
+		cache_list_.push_front(node.get());
+		live_.fetch_add(1, std::memory_order_relaxed);
+		reclaim_stale(put_reclaim_count, reclaimed);
+		record(hash, access_event::put);
+		return node.release();
+	}
+	/**
+	 * Find the element, move it to the head of the LRU list and update it's
+	 * access time. Must be called with the mutex locked.
+	 * @return the element or nullptr if there is no such key
+	 */
+	node_type*
+	lookup(key_type const& key, std::size_t hash)
+	{
+		node_type* node = find(key, hash);
+		if (!node || is_stale(*node)) {
+			record(hash, access_event::miss);
+			misses_.fetch_add(1, std::memory_order_relaxed);
+			if (ghosts_.capacity() && ghosts_.take(hash))
+				ghost_hits_.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		record(hash, access_event::hit);
+		hits_.fetch_add(1, std::memory_order_relaxed);
+		count_tail_hit(*node);
+		cache_list_.move_to_front(node);
+		set_access_time(*node, clock_traits_type::now());
+		node->meta |= node_type::flag_referenced;
+		return node;
+	}
+	/**
+	 * Move the element to the head of the LRU list and update it's access
+	 * time, if it's still in the container. Is not counted in the cache
+	 * statistics. Must be called with the mutex locked.
+	 */
+	void
+	refresh(key_type const& key, std::size_t hash, time_type now)
+	{
+		node_type* node = find(key, hash);
+		if (node && !is_stale(*node)) {
+			count_tail_hit(*node);
+			cache_list_.move_to_front(node);
+			set_access_time(*node, now);
+			node->meta |= node_type::flag_referenced;
+		}
+	}
+	/**
+	 * Propagate pending hits of the thread's front cache slots owned by
+	 * this container: move the elements to the head of the LRU list, update
+	 * their access times and add the hits to the statistics.
+	 * Must be called with the mutex locked.
+	 */
+	void
+	propagate_front_hits(front_local_type& local)
+	{
+		if (local.pending.empty())
+			return;
+		time_type now = clock_traits_type::now();
+		std::uint64_t hits = 0;
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < local.pending.size(); ++i) {
+			front_slot_type& slot = local.slots[local.pending[i]];
+			if (slot.owner != instance_id_) {
+				local.pending[kept++] = local.pending[i];
+				continue;
+			}
+			slot.queued = false;
+			if (slot.hits && slot.entry) {
+				refresh(slot.entry->first, slot.hash, now);
+				hits += slot.hits;
+			}
+			slot.hits = 0;
+		}
+		local.pending.resize(kept);
+		if (hits)
+			hits_.fetch_add(hits, std::memory_order_relaxed);
+	}
+	/**
+	 * Same as lookup, but throws if there is no such key
+	 */
+	node_type*
+	touch(key_type const& key, std::size_t hash)
+	{
+		node_type* node = lookup(key, hash);
+		if (!node)
+			throw_missing(key);
+		return node;
+	}
+	[[noreturn]] static void
+	throw_missing(key_type const& key)
+	{
+		std::ostringstream os("No key ");
+		os << key << " in cache of " << typeid(value_type).name();
+		throw std::range_error(os.str());
+	}
+	void
+	record(std::size_t hash, access_event event) const
+	{
+		if (recording_.load(std::memory_order_acquire)) {
+			access_recorder_ptr recorder = std::atomic_load(&recorder_);
+			if (recorder) {
+				try {
+					recorder->record(hash, event);
+				} catch (...) {}
+			}
+		}
+	}
+	void
+	bump_epoch()
+	{
+		epoch_.fetch_add(1, std::memory_order_release);
 	}
 private:
 	mutable mutex_type	mutex_;
 	lru_list_type		cache_list_;
-	lru_map_type		cache_map_;
+	lru_index_type		index_;
 
 	get_key_function	get_key_;
 	get_time_function	get_time_;
 	set_time_function	set_time_;
+	time_type			start_time_;
+
+	std::uint32_t		generation_;
+	size_t				stale_;
+	std::atomic< size_t >	live_;
+
+	access_recorder_ptr	recorder_;
+	std::atomic< bool >	recording_;
+
+	ghost_list						ghosts_;
+	std::atomic< std::uint64_t >	hits_;
+	std::atomic< std::uint64_t >	misses_;
+	std::atomic< std::uint64_t >	ghost_hits_;
+	std::atomic< std::uint64_t >	evictions_;
+	std::atomic< std::uint64_t >	unused_evictions_;
+	std::atomic< std::uint64_t >	rejections_;
+	std::atomic< std::uint64_t >	tail_hits_;
+	std::atomic< size_t >			admission_limit_;
+	size_t							tail_count_;
+	std::uint32_t					tail_tick_;
+
+	std::uint64_t const				instance_id_;
+	std::atomic< std::uint64_t >	epoch_;
+	std::atomic< std::size_t >		front_mask_;
+	std::atomic< std::uint64_t >	front_max_lag_;
+	std::atomic< std::uint32_t >	front_refresh_;
 };
 
 template < typename KeyTag, typename TimeTag, typename KeyExtraction, typename TimeHandling >
@@ -293,14 +1493,12 @@ struct cache_value_holder < non_intrusive, non_intrusive, KeyExtraction, TimeHan
 	typedef cache_types < KeyExtraction, TimeHandling > types;
 	typename types::key_type 	key_;
 	typename types::value_type	value_;
-	typename types::time_type	access_time_;
 };
 
 template < typename KeyExtraction, typename TimeHandling >
 struct cache_value_holder < intrusive, non_intrusive, KeyExtraction, TimeHandling > {
 	typedef cache_types < KeyExtraction, TimeHandling > types;
 	typename types::value_type	value_;
-	typename types::time_type	access_time_;
 };
 
 template < typename KeyExtraction, typename TimeHandling >
@@ -316,55 +1514,134 @@ struct cache_value_holder < intrusive, intrusive, KeyExtraction, TimeHandling >
 	typename types::value_type	value_;
 };
 
-template < typename KeyTag, typename TimeTag, typename KeyExtraction, typename TimeHandling >
+/**
+ * Operations of caches keeping keys apart from values
+ */
+template < typename CacheTypes, typename ValueHolder >
+class keyed_cache : public cache_container< CacheTypes, ValueHolder > {
+public:
+	typedef CacheTypes										types;
+	typedef ValueHolder										value_holder_type;
+	typedef cache_container< types, value_holder_type >		base_type;
+	typedef typename types::key_type						key_type;
+	typedef typename types::value_type						value_type;
+protected:
+	typedef typename base_type::get_key_function			get_key_function;
+	typedef typename base_type::get_time_function			get_time_function;
+	typedef typename base_type::set_time_function			set_time_function;
+public:
+	keyed_cache() : base_type()
+	{
+	}
+	keyed_cache(get_key_function key_fn, get_time_function get_time_fn,
+			set_time_function set_time_fn) :
+		base_type(key_fn, get_time_fn, set_time_fn)
+	{
+	}
+
+	bool
+	put(key_type const& key, value_type const& value)
+	{
+		return base_type::put(key, value_holder_type{ key, value });
+	}
+	/**
+	 * Update the value in place, a default constructed value is put to the
+	 * cache if there is no such key. The function is called with the cache
+	 * locked and must not access the cache.
+	 * @param key
+	 * @param fn function taking value_type&
+	 * @return false if the new value was rejected because of the admission
+	 * 		limit
+	 */
+	template < typename Fn >
+	bool
+	compute(key_type const& key, Fn fn)
+	{
+		return base_type::modify(key, fn,
+			[&key]()
+			{ return value_holder_type{ key, value_type{} }; },
+			true);
+	}
+	/**
+	 * Update the value in place if there is such key. The function is
+	 * called with the cache locked and must not access the cache.
+	 * @param key
+	 * @param fn function taking value_type&
+	 * @return true if the value was updated
+	 */
+	template < typename Fn >
+	bool
+	compute_if_present(key_type const& key, Fn fn)
+	{
+		return base_type::modify(key, fn);
+	}
+	/**
+	 * Put the value to the cache if there is no such key, otherwise merge
+	 * it into the stored value in place. The function is called with the
+	 * cache locked and must not access the cache.
+	 * @param key
+	 * @param value
+	 * @param fn function taking value_type& of the stored value and
+	 * 		value_type const& of the merged one
+	 * @return false if the new value was rejected because of the admission
+	 * 		limit
+	 */
+	template < typename Fn >
+	bool
+	merge(key_type const& key, value_type const& value, Fn fn)
+	{
+		return base_type::modify(key,
+			[&value, &fn](value_type& stored)
+			{ fn(stored, value); },
+			[&key, &value]()
+			{ return value_holder_type{ key, value }; },
+			false);
+	}
+};
+
+template < typename KeyTag, typename TimeTag, typename KeyExtraction,
+		typename TimeHandling, typename Locking >
 class basic_cache;
 
-template < typename KeyExtraction, typename TimeHandling >
-class basic_cache <non_intrusive, non_intrusive, KeyExtraction, TimeHandling > :
-		public cache_container<
-				cache_types< KeyExtraction, TimeHandling >,
+template < typename KeyExtraction, typename TimeHandling, typename Locking >
+class basic_cache <non_intrusive, non_intrusive, KeyExtraction, TimeHandling, Locking > :
+		public keyed_cache<
+				cache_types< KeyExtraction, TimeHandling, Locking >,
 				cache_value_holder< non_intrusive, non_intrusive,
 						KeyExtraction, TimeHandling >
 			> {
 public:
-	typedef cache_types < KeyExtraction, TimeHandling >		types;
+	typedef cache_types < KeyExtraction, TimeHandling, Locking >	types;
 	typedef cache_value_holder< non_intrusive, non_intrusive,
 							KeyExtraction, TimeHandling >	value_holder_type;
-	typedef cache_container< types, value_holder_type >		base_type;
-	typedef typename base_type::element_type				element_type;
+	typedef keyed_cache< types, value_holder_type >			base_type;
+	typedef typename base_type::get_time_function			holder_get_time;
+	typedef typename base_type::set_time_function			holder_set_time;
 public:
 	basic_cache() :
 		base_type(
-			[](element_type elem)
-			{ return elem->key_; },
-			[](element_type elem)
-			{ return elem->access_time_; },
-			[](element_type elem, typename types::time_type tm)
-			{ elem->access_time_ = tm; }
+			[](value_holder_type const& holder)
+			{ return holder.key_; },
+			holder_get_time(),
+			holder_set_time()
 		)
 	{}
-
-	void
-	put(typename types::key_type const& key, typename types::value_type const& value)
-	{
-		base_type::put(key,
-				element_type( new value_holder_type{ key, value, typename types::time_type{} }) );
-	}
 };
 
-template < typename KeyExtraction, typename TimeHandling >
-class basic_cache<intrusive, non_intrusive, KeyExtraction, TimeHandling > :
+template < typename KeyExtraction, typename TimeHandling, typename Locking >
+class basic_cache <intrusive, non_intrusive, KeyExtraction, TimeHandling, Locking > :
 		public cache_container<
-				cache_types< KeyExtraction, TimeHandling >,
+				cache_types< KeyExtraction, TimeHandling, Locking >,
 				cache_value_holder< intrusive, non_intrusive,
 						KeyExtraction, TimeHandling >
 			> {
 public:
-	typedef cache_types < KeyExtraction, TimeHandling >		types;
+	typedef cache_types < KeyExtraction, TimeHandling, Locking >	types;
 	typedef cache_value_holder< intrusive, non_intrusive,
 							KeyExtraction, TimeHandling >	value_holder_type;
 	typedef cache_container< types, value_holder_type >		base_type;
-	typedef typename base_type::element_type				element_type;
+	typedef typename base_type::get_time_function			holder_get_time;
+	typedef typename base_type::set_time_function			holder_set_time;
 	typedef typename types::key_extraction_type				key_extraction_type;
 	typedef typename key_extraction_type::get_key_function	get_key_function;
 public:
@@ -373,39 +1650,37 @@ public:
 	}
 	basic_cache(get_key_function get_key) :
 		base_type(
-			[get_key](element_type elem)
-			{ return get_key( elem->value_ ); },
-			[](element_type elem)
-			{ return elem->access_time_; },
-			[](element_type elem, typename types::time_type tm)
-			{ elem->access_time_ = tm; }
+			[get_key](value_holder_type const& holder)
+			{ return get_key( holder.value_ ); },
+			holder_get_time(),
+			holder_set_time()
 		), get_key_(get_key)
 	{}
 
-	void
+	bool
 	put(typename types::value_type const& value)
 	{
 		typename types::key_type const& key = get_key_(value);
-		base_type::put(key,
-				element_type( new value_holder_type{ value, typename types::time_type{} }) );
+		return base_type::put(key, value_holder_type{ value });
 	}
 private:
 	get_key_function get_key_;
 };
 
-template < typename KeyExtraction, typename TimeHandling >
-class basic_cache<intrusive, intrusive, KeyExtraction, TimeHandling > :
+template < typename KeyExtraction, typename TimeHandling, typename Locking >
+class basic_cache <intrusive, intrusive, KeyExtraction, TimeHandling, Locking > :
 		public cache_container<
-				cache_types< KeyExtraction, TimeHandling >,
+				cache_types< KeyExtraction, TimeHandling, Locking >,
 				cache_value_holder< intrusive, intrusive,
 						KeyExtraction, TimeHandling >
 			> {
 public:
-	typedef cache_types < KeyExtraction, TimeHandling > 	types;
+	typedef cache_types < KeyExtraction, TimeHandling, Locking >	types;
 	typedef cache_value_holder< intrusive, intrusive,
 							KeyExtraction, TimeHandling > 	value_holder_type;
 	typedef cache_container< types, value_holder_type > 	base_type;
-	typedef typename base_type::element_type				element_type;
+	typedef typename base_type::get_time_function			holder_get_time;
+	typedef typename base_type::set_time_function			holder_set_time;
 	typedef typename types::key_extraction_type				key_extraction_type;
 	typedef typename types::time_handling_type				time_handling_type;
 	typedef typename key_extraction_type::get_key_function	get_key_function;
@@ -420,38 +1695,38 @@ public:
 			get_time_function get_time,
 			set_time_function set_time) :
 		base_type(
-			[get_key](element_type elem)
-			{ return get_key( elem->value_ ); },
-			[get_time](element_type elem)
-			{ return get_time(elem->value_); },
-			[set_time](element_type elem, typename types::time_type tm)
-			{ set_time(elem->value_, tm); }
+			[get_key](value_holder_type const& holder)
+			{ return get_key( holder.value_ ); },
+			[get_time](value_holder_type const& holder)
+			{ return get_time(holder.value_); },
+			[set_time](value_holder_type& holder, typename types::time_type tm)
+			{ set_time(holder.value_, tm); }
 		), get_key_(get_key)
 	{}
-	void
+	bool
 	put(typename types::value_type const& value)
 	{
 		typename types::key_type const& key = get_key_(value);
-		base_type::put(key,
-				element_type( new value_holder_type{ value }) );
+		return base_type::put(key, value_holder_type{ value });
 	}
 private:
 	get_key_function get_key_;
 };
 
-template < typename KeyExtraction, typename TimeHandling >
-class basic_cache<non_intrusive, intrusive, KeyExtraction, TimeHandling> :
-		public cache_container<
-				cache_types< KeyExtraction, TimeHandling >,
+template < typename KeyExtraction, typename TimeHandling, typename Locking >
+class basic_cache <non_intrusive, intrusive, KeyExtraction, TimeHandling, Locking > :
+		public keyed_cache<
+				cache_types< KeyExtraction, TimeHandling, Locking >,
 				cache_value_holder< non_intrusive, intrusive,
 						KeyExtraction, TimeHandling >
 			> {
 public:
-	typedef cache_types < KeyExtraction, TimeHandling >		types;
+	typedef cache_types < KeyExtraction, TimeHandling, Locking >	types;
 	typedef cache_value_holder< non_intrusive, intrusive,
 							KeyExtraction, TimeHandling >	value_holder_type;
-	typedef cache_container< types, value_holder_type >		base_type;
-	typedef typename base_type::element_type				element_type;
+	typedef keyed_cache< types, value_holder_type >			base_type;
+	typedef typename base_type::get_time_function			holder_get_time;
+	typedef typename base_type::set_time_function			holder_set_time;
 	typedef typename types::time_handling_type				time_handling_type;
 	typedef typename time_handling_type::get_time_function	get_time_function;
 	typedef typename time_handling_type::set_time_function	set_time_function;
@@ -463,25 +1738,20 @@ public:
 			get_time_function get_time,
 			set_time_function set_time) :
 		base_type(
-			[](element_type elem)
-			{ return elem->key_; },
-			[get_time](element_type elem)
-			{ return get_time(elem->value_); },
-			[set_time](element_type elem, typename types::time_type tm)
-			{ set_time(elem->value_, tm); }
+			[](value_holder_type const& holder)
+			{ return holder.key_; },
+			[get_time](value_holder_type const& holder)
+			{ return get_time(holder.value_); },
+			[set_time](value_holder_type& holder, typename types::time_type tm)
+			{ set_time(holder.value_, tm); }
 		)
 	{}
-	void
-	put(typename types::key_type const& key, typename types::value_type const& value)
-	{
-		base_type::put(key,
-				element_type( new value_holder_type{ key, value }) );
-	}
 };
 
 template < typename Value, typename Key,
 		typename T0 = std::chrono::high_resolution_clock::time_point,
-		typename T1 = void >
+		typename T1 = void,
+		typename Locking = exclusive_locking >
 struct cache_traits {
 	typedef Value										value_type;
 	typedef key_extraction_traits< Value, Key >			key_extraction_type;
@@ -498,7 +1768,8 @@ struct cache_traits {
 			key_intrusive,
 			time_intrusive,
 			key_extraction_type,
-			time_handling_type
+			time_handling_type,
+			Locking
 		> cache_base_type;
 };
 }  // namespace detail
@@ -506,13 +1777,15 @@ struct cache_traits {
 template < typename ValueType,
 	typename KeyType,
 	typename GetTime = std::chrono::high_resolution_clock::time_point,
-	typename SetTime = void >
+	typename SetTime = void,
+	typename Locking = exclusive_locking >
 class lru_cache :
-		public detail::cache_traits< ValueType, KeyType, GetTime, SetTime >::cache_base_type {
+		public detail::cache_traits< ValueType, KeyType,
+				GetTime, SetTime, Locking >::cache_base_type {
 public:
-	typedef lru_cache< ValueType, KeyType, GetTime, SetTime >		this_type;
+	typedef lru_cache< ValueType, KeyType, GetTime, SetTime, Locking >	this_type;
 	typedef detail::cache_traits<
-			ValueType, KeyType, GetTime, SetTime >					traits_type;
+			ValueType, KeyType, GetTime, SetTime, Locking >			traits_type;
 	typedef typename traits_type::value_type						value_type;
 	typedef typename traits_type::key_type							key_type;
 	typedef typename traits_type::time_type							time_type;
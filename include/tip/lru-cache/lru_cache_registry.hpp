@@ -0,0 +1,307 @@
+/*
+ * lru_cache_registry.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#ifndef TIP_LRU_CACHE_LRU_CACHE_REGISTRY_HPP_
+#define TIP_LRU_CACHE_LRU_CACHE_REGISTRY_HPP_
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <tip/lru-cache/lru_cache.hpp>
+#include <tip/lru-cache/memory_budget.hpp>
+#include <tip/lru-cache/memory_pressure.hpp>
+
+#include <map>
+
+namespace tip {
+namespace lru {
+
+namespace detail {
+
+/**
+ * Interface of a cache maintained by the registry
+ */
+class registered_cache {
+public:
+	virtual ~registered_cache() {}
+	/**
+	 * Report cache utility to the memory budget and update it's target size
+	 */
+	virtual void
+	resize() = 0;
+	/**
+	 * Expire old elements and shrink the cache to it's target size.
+	 * @param max_count maximum number of elements to remove
+	 * @return number of elements removed
+	 */
+	virtual std::size_t
+	maintain(std::size_t max_count) = 0;
+	/**
+	 * Shrink the cache and stop admitting new elements or resume admission
+	 * @return number of elements removed
+	 */
+	virtual std::size_t
+	relieve(memory_pressure_monitor const& monitor,
+			memory_pressure_action action) = 0;
+};
+
+template < typename Cache >
+class registered_cache_impl : public registered_cache {
+public:
+	typedef Cache								cache_type;
+	typedef std::shared_ptr< cache_type >		cache_ptr;
+	typedef typename cache_type::duration_type	duration_type;
+public:
+	registered_cache_impl(cache_ptr cache, duration_type max_age,
+			memory_budget_ptr budget, std::size_t min_size, std::size_t max_size) :
+		cache_(cache), max_age_(max_age),
+		sizer_(*cache_, budget, min_size, max_size),
+		target_(sizer_.target())
+	{
+	}
+	virtual ~registered_cache_impl() {}
+
+	virtual void
+	resize()
+	{
+		target_ = sizer_.update();
+	}
+	virtual std::size_t
+	maintain(std::size_t max_count)
+	{
+		std::size_t removed = cache_->expire(max_age_, max_count);
+		if (removed < max_count)
+			removed += cache_->shrink(target_, max_count - removed);
+		return removed;
+	}
+	virtual std::size_t
+	relieve(memory_pressure_monitor const& monitor,
+			memory_pressure_action action)
+	{
+		if (action == memory_pressure_action::resume) {
+			cache_->set_admission_limit(std::numeric_limits< std::size_t >::max());
+			return 0;
+		}
+		std::size_t removed = cache_->shrink(monitor.shrink_target(cache_->size()));
+		cache_->set_admission_limit(cache_->size());
+		return removed;
+	}
+private:
+	cache_ptr							cache_;
+	duration_type						max_age_;
+	budget_participant< cache_type >	sizer_;
+	std::size_t							target_;
+};
+
+}  // namespace detail
+
+/**
+ * Service maintaining a number of caches of different types with a single
+ * timer and a single memory budget.
+ * On each timer tick every cache reports it's ghost hits to the budget and
+ * gets a new target size, then old elements are expired and the caches are
+ * shrunk to their target sizes. The number of elements removed per tick is
+ * limited, when the limit is reached the next tick continues from the cache
+ * where the previous one stopped.
+ * Memory pressure handling, when enabled, shrinks all the caches regardless
+ * of the limit.
+ */
+class lru_cache_registry : public boost::asio::detail::service_base< lru_cache_registry > {
+public:
+	typedef boost::asio::io_service io_service;
+	typedef boost::asio::detail::service_base< lru_cache_registry > service_base;
+	typedef boost::asio::deadline_timer deadline_timer;
+	typedef deadline_timer::duration_type timer_iterval_type;
+	typedef std::uint64_t registration_id;
+	typedef std::mutex mutex_type;
+	typedef std::lock_guard< mutex_type > lock_type;
+public:
+	//@{
+	/** @name Constructor required for compiling use_service template function */
+	lru_cache_registry( io_service& owner ) :
+			service_base(owner),
+			timer_interval_(), max_removals_(0),
+			timer_(owner, timer_interval_)
+	{
+		throw std::logic_error("LRU Cache registry must be added manually to "
+				"io_service before it can be used");
+	}
+	//@}
+	/**
+	 * @param owner
+	 * @param timer_interval interval between maintenance ticks
+	 * @param budget memory budget shared by the registered caches, if empty
+	 * 		the caches are limited only by their maximal sizes
+	 * @param max_removals maximum number of elements removed from all the
+	 * 		caches per tick
+	 */
+	lru_cache_registry( io_service& owner,
+				timer_iterval_type timer_interval,
+				memory_budget_ptr budget = memory_budget_ptr(),
+				std::size_t max_removals = 10000 ) :
+			service_base(owner),
+			timer_interval_(timer_interval),
+			budget_(budget),
+			max_removals_(max_removals ? max_removals : 1),
+			timer_(owner, timer_interval_),
+			next_id_(0), cursor_(0)
+	{
+		start_timer();
+	}
+	virtual ~lru_cache_registry() {}
+
+	/**
+	 * Register a cache. The registry shares ownership of the cache until it
+	 * is removed.
+	 * @param cache
+	 * @param max_age elements not accessed for longer are expired
+	 * @param min_size minimal number of elements the budget leaves to the cache
+	 * @param max_size maximal number of elements, without a budget the cache
+	 * 		is shrunk to this size
+	 * @return registration id
+	 */
+	template < typename Cache >
+	registration_id
+	add(std::shared_ptr< Cache > cache,
+			typename Cache::duration_type max_age,
+			std::size_t min_size = 0,
+			std::size_t max_size = std::numeric_limits< std::size_t >::max())
+	{
+		typedef detail::registered_cache_impl< Cache > impl_type;
+		registered_cache_ptr reg(
+				new impl_type(cache, max_age, budget_, min_size, max_size));
+		lock_type lock(mutex_);
+		registration_id id = ++next_id_;
+		caches_.insert(std::make_pair(id, reg));
+		return id;
+	}
+	void
+	remove(registration_id id)
+	{
+		lock_type lock(mutex_);
+		caches_.erase(id);
+	}
+	std::size_t
+	size() const
+	{
+		lock_type lock(mutex_);
+		return caches_.size();
+	}
+	memory_budget_ptr
+	budget() const
+	{
+		return budget_;
+	}
+	/**
+	 * Watch memory usage on each timer tick. While the usage is above the
+	 * high watermark every cache is shrunk by a percent of it's size per
+	 * tick and puts of new keys are rejected, until the usage falls below
+	 * the low watermark.
+	 * @param probe memory usage source, e.g. cgroup_memory_probe
+	 * @param opts watermarks and shrink percent
+	 * @param callback is called on each action taken, with the registry
+	 * 		locked but none of the caches locked. The callback may access
+	 * 		the caches, but must not add or remove caches, the registry's
+	 * 		lock is not recursive.
+	 */
+	void
+	enable_memory_pressure(memory_probe probe,
+			memory_pressure_options const& opts = memory_pressure_options(),
+			memory_pressure_callback callback = memory_pressure_callback())
+	{
+		std::unique_ptr< memory_pressure_monitor > monitor(
+				new memory_pressure_monitor(probe, opts, callback));
+		lock_type lock(mutex_);
+		pressure_.swap(monitor);
+	}
+	/**
+	 * Run a maintenance pass immediately
+	 * @return number of elements removed
+	 */
+	std::size_t
+	maintain()
+	{
+		lock_type lock(mutex_);
+		for (auto& c : caches_) {
+			c.second->resize();
+		}
+		std::size_t removed = 0;
+		auto p = caches_.lower_bound(cursor_);
+		for (std::size_t visited = 0;
+				visited < caches_.size() && removed < max_removals_; ++visited) {
+			if (p == caches_.end())
+				p = caches_.begin();
+			std::size_t limit = max_removals_ - removed;
+			std::size_t n = p->second->maintain(limit);
+			removed += n;
+			if (n < limit)
+				++p;
+		}
+		cursor_ = p == caches_.end() ? 0 : p->first;
+		if (pressure_)
+			removed += check_memory_pressure();
+		return removed;
+	}
+private:
+	typedef std::shared_ptr< detail::registered_cache >		registered_cache_ptr;
+	typedef std::map< registration_id, registered_cache_ptr >	cache_map;
+
+	virtual void
+	shutdown_service()
+	{
+		timer_.cancel();
+		lock_type lock(mutex_);
+		caches_.clear();
+	}
+	/**
+	 * Must be called with the mutex locked
+	 */
+	std::size_t
+	check_memory_pressure()
+	{
+		memory_pressure_event event;
+		if (!pressure_->check(event))
+			return 0;
+		for (auto& c : caches_) {
+			event.removed += c.second->relieve(*pressure_, event.action);
+		}
+		pressure_->notify(event);
+		return event.removed;
+	}
+	void
+	start_timer()
+	{
+		timer_.async_wait(
+				std::bind(&lru_cache_registry::timer_expired,
+						this, std::placeholders::_1));
+	}
+	void
+	timer_expired( boost::system::error_code const& ec)
+	{
+		if (ec == boost::asio::error::operation_aborted)
+			return;
+		maintain();
+		timer_.expires_at(timer_.expires_at() + timer_interval_);
+		start_timer();
+	}
+private:
+	timer_iterval_type			timer_interval_;
+	memory_budget_ptr			budget_;
+	std::size_t					max_removals_;
+	deadline_timer				timer_;
+
+	mutable mutex_type			mutex_;
+	registration_id				next_id_;
+	registration_id				cursor_;
+	cache_map					caches_;
+	std::unique_ptr< memory_pressure_monitor >	pressure_;
+};
+
+}  // namespace lru
+}  // namespace tip
+
+#endif /* TIP_LRU_CACHE_LRU_CACHE_REGISTRY_HPP_ */
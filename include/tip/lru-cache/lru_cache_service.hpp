@@ -12,6 +12,8 @@
 #include <boost/asio/deadline_timer.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <tip/lru-cache/lru_cache.hpp>
+#include <tip/lru-cache/memory_budget.hpp>
+#include <tip/lru-cache/memory_pressure.hpp>
 
 namespace tip {
 namespace lru {
@@ -19,23 +21,25 @@ namespace lru {
 template < typename Value,
 		typename GetKey,
 		typename GetTime = boost::posix_time::ptime,
-		typename SetTime = void >
+		typename SetTime = void,
+		typename Locking = util::exclusive_locking >
 class lru_cache_service : public boost::asio::detail::service_base<
-			lru_cache_service<Value, GetKey, GetTime, SetTime>>,
-		public util::lru_cache< Value, GetKey, GetTime, SetTime > {
+			lru_cache_service<Value, GetKey, GetTime, SetTime, Locking>>,
+		public util::lru_cache< Value, GetKey, GetTime, SetTime, Locking > {
 public:
-	typedef lru_cache_service< Value, GetKey, GetTime, SetTime > this_type;
+	typedef lru_cache_service< Value, GetKey, GetTime, SetTime, Locking > this_type;
 	typedef boost::asio::io_service io_service;
 	typedef boost::asio::detail::service_base<
-			lru_cache_service<Value, GetKey, GetTime, SetTime>
+			lru_cache_service<Value, GetKey, GetTime, SetTime, Locking>
 		> service_base;
-	typedef util::lru_cache< Value, GetKey, GetTime, SetTime > container_base;
+	typedef util::lru_cache< Value, GetKey, GetTime, SetTime, Locking > container_base;
 	typedef typename container_base::key_intrusive key_intrusive;
 	typedef typename container_base::time_intrusive time_intrusive;
 
 	typedef typename container_base::duration_type	duration_type;
 	typedef boost::asio::deadline_timer deadline_timer;
 	typedef deadline_timer::duration_type timer_iterval_type;
+	typedef budget_participant< container_base > budget_participant_type;
 public:
 	//@{
 	/** @name Constructors required for compiling use_service template function */
@@ -103,12 +107,64 @@ public:
 	//@}
 
 	virtual ~lru_cache_service() {}
+
+	/**
+	 * Let the cache size itself between min_size and max_size.
+	 * On each timer tick the cache reports the number of misses on recently
+	 * evicted keys to the memory budget and is shrunk to the size the budget
+	 * allots to it. Should be called before the io_service is run.
+	 * @param min_size minimal number of elements
+	 * @param max_size maximal number of elements
+	 * @param budget memory budget shared with other caches, if empty the
+	 * 		cache is limited only by max_size
+	 */
+	void
+	enable_auto_sizing(std::size_t min_size, std::size_t max_size,
+			memory_budget_ptr budget = memory_budget_ptr())
+	{
+		sizer_.reset();
+		sizer_.reset(new budget_participant_type(*this, budget, min_size, max_size));
+		container_base::shrink(sizer_->target());
+	}
+	/**
+	 * Number of elements the auto sized cache is allowed to hold
+	 */
+	std::size_t
+	target_size() const
+	{
+		return sizer_ ? sizer_->target() :
+				std::numeric_limits< std::size_t >::max();
+	}
+	/**
+	 * Watch memory usage on each timer tick. While the usage is above the
+	 * high watermark the cache is shrunk by a percent of it's size per tick
+	 * and puts of new keys are rejected, until the usage falls below the low
+	 * watermark. Should be called before the io_service is run.
+	 * @param probe memory usage source, e.g. cgroup_memory_probe
+	 * @param opts watermarks and shrink percent
+	 * @param callback is called on each action taken, after the cache is
+	 * 		shrunk and unlocked, so it may access the cache
+	 */
+	void
+	enable_memory_pressure(memory_probe probe,
+			memory_pressure_options const& opts = memory_pressure_options(),
+			memory_pressure_callback callback = memory_pressure_callback())
+	{
+		pressure_.reset(new memory_pressure_monitor(probe, opts, callback));
+	}
+	void
+	disable_memory_pressure()
+	{
+		pressure_.reset();
+		container_base::set_admission_limit(std::numeric_limits< std::size_t >::max());
+	}
 private:
 	virtual void
 	shutdown_service()
 	{
 		timer_.cancel();
 		container_base::clear();
+		container_base::reclaim();
 	}
 	void
 	start_timer()
@@ -121,13 +177,36 @@ private:
 	timer_expired( boost::system::error_code const&)
 	{
 		container_base::expire(max_age_);
+		if (sizer_)
+			container_base::shrink(sizer_->update());
+		if (pressure_)
+			check_memory_pressure();
 		timer_.expires_at(timer_.expires_at() + timer_interval_);
 		start_timer();
 	}
+	void
+	check_memory_pressure()
+	{
+		memory_pressure_event event;
+		if (!pressure_->check(event))
+			return;
+		if (event.action == memory_pressure_action::shrink) {
+			event.removed = container_base::shrink(
+					pressure_->shrink_target(container_base::size()));
+			container_base::set_admission_limit(container_base::size());
+		} else {
+			container_base::set_admission_limit(
+					std::numeric_limits< std::size_t >::max());
+		}
+		pressure_->notify(event);
+	}
 private:
 	timer_iterval_type			timer_interval_;
 	duration_type				max_age_;
 	deadline_timer				timer_;
+
+	std::unique_ptr< budget_participant_type >	sizer_;
+	std::unique_ptr< memory_pressure_monitor >	pressure_;
 };
 
 }  // namespace lru
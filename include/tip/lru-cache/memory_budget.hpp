@@ -0,0 +1,378 @@
+/*
+ * memory_budget.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#ifndef TIP_LRU_CACHE_MEMORY_BUDGET_HPP_
+#define TIP_LRU_CACHE_MEMORY_BUDGET_HPP_
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <limits>
+
+namespace tip {
+namespace lru {
+
+/**
+ * Memory budget shared by several caches.
+ * Each participating cache has minimal and maximal size and reports it's
+ * utility - number of hits it would gain per an additional element, as
+ * measured by ghost hits, and it's cost - number of hits it would lose per
+ * an element removed, as measured by hits in the tail of the LRU list.
+ * Memory is moved step by step from the caches with the lowest cost per
+ * byte to the ones with utility per byte higher than that cost.
+ */
+class memory_budget {
+public:
+	typedef std::uint64_t					participant_id;
+	typedef std::mutex						mutex_type;
+	typedef std::lock_guard< mutex_type >	lock_type;
+public:
+	/**
+	 * @param bytes total number of bytes available for the caches
+	 * @param steps number of steps a cache takes to grow from it's minimal
+	 * 		to it's maximal size or to the whole budget
+	 * @param max_step maximum number of elements a cache grows by per update
+	 */
+	explicit
+	memory_budget(std::size_t bytes, std::size_t steps = 16,
+			std::size_t max_step = 65536) :
+		bytes_(bytes), steps_(steps ? steps : 1),
+		max_step_(max_step ? max_step : 1), next_id_(0)
+	{
+	}
+
+	/**
+	 * Add a cache to the budget. The cache starts with it's minimal size.
+	 * @param min_size minimal number of elements
+	 * @param max_size maximal number of elements
+	 * @param entry_size estimated number of bytes per element
+	 * @return participant id
+	 */
+	participant_id
+	add(std::size_t min_size, std::size_t max_size, std::size_t entry_size)
+	{
+		if (min_size > max_size) {
+			throw std::logic_error("Cache minimal size exceeds maximal size");
+		}
+		lock_type lock(mutex_);
+		participant_id id = ++next_id_;
+		participant p;
+		p.min_size = min_size;
+		p.max_size = max_size;
+		p.entry_size = entry_size ? entry_size : 1;
+		p.target = min_size;
+		p.utility = 0;
+		p.cost = 0;
+		participants_.insert(std::make_pair(id, p));
+		return id;
+	}
+	void
+	remove(participant_id id)
+	{
+		lock_type lock(mutex_);
+		participants_.erase(id);
+	}
+	/**
+	 * Report utility of the cache and rebalance the budget. The cost of
+	 * shrinking the cache is assumed to be equal to the utility.
+	 * @param id participant id
+	 * @param utility hits per additional element since the last update
+	 * @return number of elements the cache should be shrunk to
+	 */
+	std::size_t
+	update(participant_id id, double utility)
+	{
+		return update(id, utility, utility);
+	}
+	/**
+	 * Report utility and cost of the cache and rebalance the budget.
+	 * @param id participant id
+	 * @param utility hits per additional element since the last update
+	 * @param cost hits per removed element since the last update
+	 * @return number of elements the cache should be shrunk to
+	 */
+	std::size_t
+	update(participant_id id, double utility, double cost)
+	{
+		lock_type lock(mutex_);
+		participant& p = get(id);
+		p.utility = utility / p.entry_size;
+		p.cost = cost / p.entry_size;
+		enforce_limit();
+		if (p.utility > 0 && p.target < p.max_size) {
+			grow(id, p);
+		}
+		return p.target;
+	}
+	/**
+	 * Current number of elements the cache is allowed to hold
+	 */
+	std::size_t
+	target(participant_id id) const
+	{
+		lock_type lock(mutex_);
+		return get(id).target;
+	}
+	/**
+	 * Number of elements a cache grows or shrinks by per update
+	 */
+	std::size_t
+	step(participant_id id) const
+	{
+		lock_type lock(mutex_);
+		return step(get(id));
+	}
+	std::size_t
+	bytes() const
+	{
+		lock_type lock(mutex_);
+		return bytes_;
+	}
+	void
+	set_bytes(std::size_t bytes)
+	{
+		lock_type lock(mutex_);
+		bytes_ = bytes;
+		enforce_limit();
+	}
+	/**
+	 * Number of bytes allotted to the caches
+	 */
+	std::size_t
+	used() const
+	{
+		lock_type lock(mutex_);
+		return used_bytes();
+	}
+private:
+	struct participant {
+		std::size_t		min_size;
+		std::size_t		max_size;
+		std::size_t		entry_size;
+		std::size_t		target;
+		/** Utility per byte */
+		double			utility;
+		/** Cost of shrinking per byte */
+		double			cost;
+	};
+	typedef std::map< participant_id, participant >	participant_map;
+
+	participant&
+	get(participant_id id)
+	{
+		auto f = participants_.find(id);
+		if (f == participants_.end()) {
+			throw std::logic_error("Unknown memory budget participant");
+		}
+		return f->second;
+	}
+	participant const&
+	get(participant_id id) const
+	{
+		return const_cast< memory_budget* >(this)->get(id);
+	}
+	static std::size_t
+	add_sat(std::size_t a, std::size_t b)
+	{
+		return a > std::numeric_limits< std::size_t >::max() - b ?
+				std::numeric_limits< std::size_t >::max() : a + b;
+	}
+	static std::size_t
+	mul_sat(std::size_t a, std::size_t b)
+	{
+		return b && a > std::numeric_limits< std::size_t >::max() / b ?
+				std::numeric_limits< std::size_t >::max() : a * b;
+	}
+	/**
+	 * Step is a fraction of the size range or of the whole budget, whichever
+	 * is smaller, but no more than max_step elements
+	 */
+	std::size_t
+	step(participant const& p) const
+	{
+		std::size_t s = std::min((p.max_size - p.min_size) / steps_,
+				bytes_ / p.entry_size / steps_);
+		return std::max< std::size_t >(std::min(s, max_step_), 1);
+	}
+	std::size_t
+	used_bytes() const
+	{
+		std::size_t used = 0;
+		for (auto const& p : participants_) {
+			used = add_sat(used, mul_sat(p.second.target, p.second.entry_size));
+		}
+		return used;
+	}
+	/**
+	 * Participants with size above minimal, lowest cost first
+	 */
+	std::vector< participant* >
+	donors(participant_id except)
+	{
+		std::vector< participant* > res;
+		for (auto& p : participants_) {
+			if (p.first != except && p.second.target > p.second.min_size)
+				res.push_back(&p.second);
+		}
+		std::stable_sort(res.begin(), res.end(),
+			[](participant const* lhs, participant const* rhs)
+			{ return lhs->cost < rhs->cost; });
+		return res;
+	}
+	/**
+	 * Take bytes from the donors, lowest cost first.
+	 * @param bytes number of bytes to release
+	 * @param max_cost only take from donors with cost below this one
+	 * @return number of bytes released
+	 */
+	std::size_t
+	release(std::size_t bytes, participant_id except, double max_cost)
+	{
+		std::size_t released = 0;
+		for (participant* d : donors(except)) {
+			if (released >= bytes || d->cost >= max_cost)
+				break;
+			std::size_t rest = bytes - released;
+			std::size_t want = rest / d->entry_size +
+					(rest % d->entry_size ? 1 : 0);
+			std::size_t take = std::min(want, d->target - d->min_size);
+			d->target -= take;
+			released = add_sat(released, mul_sat(take, d->entry_size));
+		}
+		return released;
+	}
+	void
+	enforce_limit()
+	{
+		std::size_t used = used_bytes();
+		if (used > bytes_) {
+			release(used - bytes_, 0, std::numeric_limits< double >::infinity());
+		}
+	}
+	void
+	grow(participant_id id, participant& p)
+	{
+		std::size_t want = std::min(step(p), p.max_size - p.target);
+		std::size_t used = used_bytes();
+		std::size_t free = used < bytes_ ? bytes_ - used : 0;
+		std::size_t need = mul_sat(want, p.entry_size);
+		if (free < need) {
+			free = add_sat(free, release(need - free, id, p.utility));
+		}
+		p.target += std::min(want, free / p.entry_size);
+	}
+private:
+	mutable mutex_type	mutex_;
+	std::size_t			bytes_;
+	std::size_t			steps_;
+	std::size_t			max_step_;
+	participant_id		next_id_;
+	participant_map		participants_;
+};
+
+typedef std::shared_ptr< memory_budget > memory_budget_ptr;
+
+/**
+ * Connects a cache to a memory budget. Reports ghost hits of the cache as
+ * it's utility and hits in the tail of it's LRU list as it's cost, keeps
+ * the cache's ghost list and marked tail one budget step long.
+ * Without a budget the cache's target size is it's maximal size.
+ * Doesn't shrink the cache itself.
+ */
+template < typename Cache >
+class budget_participant {
+public:
+	typedef Cache		cache_type;
+public:
+	/**
+	 * @param cache cache to size, must outlive the participant
+	 * @param budget memory budget, if empty the cache is limited only by
+	 * 		max_size
+	 * @param min_size minimal number of elements
+	 * @param max_size maximal number of elements
+	 */
+	budget_participant(cache_type& cache, memory_budget_ptr budget,
+			std::size_t min_size, std::size_t max_size) :
+		cache_(cache), budget_(budget), id_(0), max_size_(max_size),
+		last_ghost_hits_(cache_.stats().ghost_hits),
+		last_tail_hits_(cache_.stats().tail_hits), tail_(0)
+	{
+		if (min_size > max_size) {
+			throw std::logic_error("Cache minimal size exceeds maximal size");
+		}
+		if (budget_) {
+			id_ = budget_->add(min_size, max_size, cache_type::entry_size());
+			std::size_t step = budget_->step(id_);
+			cache_.set_ghost_capacity(step);
+			tail_ = cache_.mark_tail(step);
+		}
+	}
+	budget_participant(budget_participant const&) = delete;
+	budget_participant&
+	operator = (budget_participant const&) = delete;
+	~budget_participant()
+	{
+		if (budget_) {
+			budget_->remove(id_);
+			cache_.mark_tail(0);
+		}
+	}
+
+	/**
+	 * Report ghost hits and tail hits since the last update to the budget
+	 * @return number of elements the cache should be shrunk to
+	 */
+	std::size_t
+	update()
+	{
+		if (!budget_)
+			return max_size_;
+		auto stats = cache_.stats();
+		std::size_t ghosts = cache_.ghost_capacity();
+		double utility = ghosts ?
+				double(stats.ghost_hits - last_ghost_hits_) / ghosts : 0.0;
+		double cost = tail_ ?
+				double(stats.tail_hits - last_tail_hits_) / tail_ : 0.0;
+		last_ghost_hits_ = stats.ghost_hits;
+		last_tail_hits_ = stats.tail_hits;
+		std::size_t target = budget_->update(id_, utility, cost);
+		std::size_t step = budget_->step(id_);
+		cache_.set_ghost_capacity(step);
+		tail_ = cache_.mark_tail(step);
+		return target;
+	}
+	/**
+	 * Number of elements the cache is allowed to hold
+	 */
+	std::size_t
+	target() const
+	{
+		return budget_ ? budget_->target(id_) : max_size_;
+	}
+	memory_budget_ptr
+	budget() const
+	{
+		return budget_;
+	}
+private:
+	cache_type&						cache_;
+	memory_budget_ptr				budget_;
+	memory_budget::participant_id	id_;
+	std::size_t						max_size_;
+	std::uint64_t					last_ghost_hits_;
+	std::uint64_t					last_tail_hits_;
+	std::size_t						tail_;
+};
+
+}  // namespace lru
+}  // namespace tip
+
+#endif /* TIP_LRU_CACHE_MEMORY_BUDGET_HPP_ */
@@ -0,0 +1,199 @@
+/*
+ * memory_pressure.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#ifndef TIP_LRU_CACHE_MEMORY_PRESSURE_HPP_
+#define TIP_LRU_CACHE_MEMORY_PRESSURE_HPP_
+
+#include <functional>
+#include <fstream>
+#include <string>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+
+namespace tip {
+namespace lru {
+
+/**
+ * Memory usage of the process or it's control group
+ */
+struct memory_reading {
+	/** Number of bytes used */
+	std::size_t		current;
+	/** Number of bytes allowed */
+	std::size_t		limit;
+};
+
+/**
+ * Function reading memory usage.
+ * @return false if the usage is not available or is not limited
+ */
+typedef std::function< bool(memory_reading&) > memory_probe;
+
+/**
+ * Memory probe reading cgroup v2 memory.current and memory.max files
+ */
+class cgroup_memory_probe {
+public:
+	/**
+	 * @param cgroup_dir directory of the control group, by default the
+	 * 		control group of the process in a container
+	 */
+	explicit
+	cgroup_memory_probe(std::string const& cgroup_dir = "/sys/fs/cgroup") :
+		current_file_(cgroup_dir + "/memory.current"),
+		max_file_(cgroup_dir + "/memory.max")
+	{
+	}
+
+	bool
+	operator()(memory_reading& reading) const
+	{
+		std::size_t current, limit;
+		if (!read_value(current_file_, current) || !read_value(max_file_, limit))
+			return false;
+		reading.current = current;
+		reading.limit = limit;
+		return true;
+	}
+private:
+	/**
+	 * Read a number from the file. memory.max contains "max" when there is
+	 * no limit, it is treated as a failure.
+	 */
+	static bool
+	read_value(std::string const& file_name, std::size_t& value)
+	{
+		std::ifstream file(file_name.c_str());
+		unsigned long long v;
+		if (!(file >> v))
+			return false;
+		value = static_cast< std::size_t >(v);
+		return true;
+	}
+private:
+	std::string		current_file_;
+	std::string		max_file_;
+};
+
+/**
+ * Thresholds of memory pressure handling, fractions of the memory limit
+ */
+struct memory_pressure_options {
+	/** Caches are shrunk while the usage is at or above this fraction */
+	double			high_watermark	= 0.9;
+	/** Admission of new elements is resumed below this fraction */
+	double			low_watermark	= 0.8;
+	/** Percent of elements removed from a cache per timer tick under pressure */
+	unsigned		shrink_percent	= 10;
+};
+
+/**
+ * Action taken on memory pressure
+ */
+enum class memory_pressure_action {
+	/** Caches were shrunk and new elements are not admitted */
+	shrink,
+	/** The pressure is gone, new elements are admitted again */
+	resume
+};
+
+struct memory_pressure_event {
+	memory_pressure_action	action;
+	memory_reading			reading;
+	/** Number of elements removed from the caches */
+	std::size_t				removed;
+};
+
+typedef std::function< void(memory_pressure_event const&) >
+		memory_pressure_callback;
+
+/**
+ * Compares memory readings with the watermarks. Caches are shrunk on every
+ * check while the usage is above the high watermark, admission of new
+ * elements is suspended when the usage first crosses the high watermark
+ * and resumed when it falls below the low one.
+ */
+class memory_pressure_monitor {
+public:
+	memory_pressure_monitor(memory_probe probe,
+			memory_pressure_options const& opts,
+			memory_pressure_callback callback) :
+		probe_(probe), opts_(opts), callback_(callback), under_pressure_(false)
+	{
+		if (!probe_) {
+			throw std::logic_error("Memory probe is empty");
+		}
+		if (opts_.low_watermark > opts_.high_watermark) {
+			throw std::logic_error("Memory low watermark exceeds high watermark");
+		}
+	}
+
+	/**
+	 * Read the memory usage.
+	 * @param event filled with the action to take and the reading
+	 * @return true if an action should be taken
+	 */
+	bool
+	check(memory_pressure_event& event)
+	{
+		memory_reading reading;
+		if (!probe_(reading) || reading.limit == 0)
+			return false;
+		double usage = double(reading.current) / reading.limit;
+		event.reading = reading;
+		event.removed = 0;
+		if (usage >= opts_.high_watermark) {
+			under_pressure_ = true;
+			event.action = memory_pressure_action::shrink;
+			return true;
+		}
+		if (under_pressure_ && usage < opts_.low_watermark) {
+			under_pressure_ = false;
+			event.action = memory_pressure_action::resume;
+			return true;
+		}
+		return false;
+	}
+	/**
+	 * Number of elements a cache of the size should be shrunk to
+	 */
+	std::size_t
+	shrink_target(std::size_t size) const
+	{
+		std::size_t percent = std::min(opts_.shrink_percent, 100u);
+		std::size_t remove = (size / 100) * percent + (size % 100) * percent / 100;
+		if (!remove && size && percent)
+			remove = 1;
+		return size - remove;
+	}
+	/**
+	 * Report the action taken to the callback
+	 */
+	void
+	notify(memory_pressure_event const& event) const
+	{
+		if (callback_)
+			callback_(event);
+	}
+	bool
+	under_pressure() const
+	{
+		return under_pressure_;
+	}
+private:
+	memory_probe				probe_;
+	memory_pressure_options		opts_;
+	memory_pressure_callback	callback_;
+	bool						under_pressure_;
+};
+
+}  // namespace lru
+}  // namespace tip
+
+#endif /* TIP_LRU_CACHE_MEMORY_PRESSURE_HPP_ */
@@ -0,0 +1,409 @@
+/*
+ * partitioned_lru_cache.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#ifndef TIP_LRU_CACHE_PARTITIONED_LRU_CACHE_HPP_
+#define TIP_LRU_CACHE_PARTITIONED_LRU_CACHE_HPP_
+
+#include <tip/lru-cache/lru_cache.hpp>
+
+namespace tip {
+namespace util {
+
+/**
+ * LRU cache split into a number of independent partitions by key hash.
+ * Each partition is an lru_cache with it's own lock, so operations on
+ * keys in different partitions don't contend, and maintenance of the
+ * partitions can run in parallel.
+ * Eviction order is least recently used within a partition, a size limit
+ * is divided evenly between the partitions.
+ */
+template < typename ValueType,
+	typename KeyType,
+	typename GetTime = std::chrono::high_resolution_clock::time_point,
+	typename SetTime = void,
+	typename Locking = exclusive_locking >
+class partitioned_lru_cache {
+public:
+	typedef partitioned_lru_cache< ValueType, KeyType,
+			GetTime, SetTime, Locking >								this_type;
+	typedef lru_cache< ValueType, KeyType, GetTime, SetTime, Locking >	partition_type;
+	typedef typename partition_type::traits_type					traits_type;
+	typedef typename partition_type::value_type						value_type;
+	typedef typename partition_type::key_type						key_type;
+	typedef typename partition_type::time_type						time_type;
+	typedef typename partition_type::duration_type					duration_type;
+	typedef typename partition_type::key_intrusive					key_intrusive;
+	typedef typename partition_type::time_intrusive					time_intrusive;
+	typedef typename traits_type::key_extraction_type				key_extraction_type;
+	typedef typename traits_type::time_handling_type				time_handling_type;
+public:
+	//@{
+	/** @name Constructors, the partition count is followed by arguments of
+	 * the corresponding lru_cache constructor */
+	template < typename U = this_type,
+		typename SFINAE = typename
+			std::enable_if< !U::key_intrusive::value && !U::time_intrusive::value >::type >
+	explicit
+	partitioned_lru_cache(std::size_t partitions)
+	{
+		init(partitions);
+		for (auto& p : partitions_) {
+			p.reset(new partition_type());
+		}
+	}
+	template < typename U = this_type,
+		typename SFINAE = typename
+			std::enable_if< U::key_intrusive::value && !U::time_intrusive::value >::type >
+	partitioned_lru_cache(std::size_t partitions,
+			typename U::key_extraction_type::get_key_function key_extract)
+		: get_key_(key_extract)
+	{
+		init(partitions);
+		for (auto& p : partitions_) {
+			p.reset(new partition_type(key_extract));
+		}
+	}
+	template < typename U = this_type, typename SFINAE =
+			typename std::enable_if< U::key_intrusive::value && U::time_intrusive::value >::type >
+	partitioned_lru_cache(std::size_t partitions,
+			typename U::key_extraction_type::get_key_function key_extract,
+			typename U::time_handling_type::get_time_function get_time,
+			typename U::time_handling_type::set_time_function set_time)
+		: get_key_(key_extract)
+	{
+		init(partitions);
+		for (auto& p : partitions_) {
+			p.reset(new partition_type(key_extract, get_time, set_time));
+		}
+	}
+	template < typename U = this_type, typename SFINAE =
+			typename std::enable_if< !U::key_intrusive::value && U::time_intrusive::value >::type >
+	partitioned_lru_cache(std::size_t partitions,
+			typename U::time_handling_type::get_time_function get_time,
+			typename U::time_handling_type::set_time_function set_time)
+	{
+		init(partitions);
+		for (auto& p : partitions_) {
+			p.reset(new partition_type(get_time, set_time));
+		}
+	}
+	//@}
+	partitioned_lru_cache(partitioned_lru_cache const&) = delete;
+	partitioned_lru_cache&
+	operator = (partitioned_lru_cache const&) = delete;
+
+	//@{
+	/** @name Element access, routed to the key's partition */
+	template < typename U = this_type >
+	typename std::enable_if< !U::key_intrusive::value, bool >::type
+	put(key_type const& key, value_type const& value)
+	{
+		return partition_for(key).put(key, value);
+	}
+	template < typename U = this_type >
+	typename std::enable_if< U::key_intrusive::value, bool >::type
+	put(value_type const& value)
+	{
+		return partition_for(get_key_(value)).put(value);
+	}
+	/**
+	 * Update the value in place under the partition's lock, a default
+	 * constructed value is put to the cache if there is no such key.
+	 * @see lru_cache::compute
+	 */
+	template < typename Fn, typename U = this_type >
+	typename std::enable_if< !U::key_intrusive::value, bool >::type
+	compute(key_type const& key, Fn fn)
+	{
+		return partition_for(key).compute(key, fn);
+	}
+	/**
+	 * Update the value in place under the partition's lock if there is such
+	 * key.
+	 */
+	template < typename Fn, typename U = this_type >
+	typename std::enable_if< !U::key_intrusive::value, bool >::type
+	compute_if_present(key_type const& key, Fn fn)
+	{
+		return partition_for(key).compute_if_present(key, fn);
+	}
+	/**
+	 * Put the value or merge it into the stored one under the partition's
+	 * lock.
+	 */
+	template < typename Fn, typename U = this_type >
+	typename std::enable_if< !U::key_intrusive::value, bool >::type
+	merge(key_type const& key, value_type const& value, Fn fn)
+	{
+		return partition_for(key).merge(key, value, fn);
+	}
+	void
+	erase(key_type const& key)
+	{
+		partition_for(key).erase(key);
+	}
+	value_type
+	get(key_type const& key)
+	{
+		return partition_for(key).get(key);
+	}
+	value_type
+	peek(key_type const& key) const
+	{
+		return partition_for(key).peek(key);
+	}
+	bool
+	exists(key_type const& key) const
+	{
+		return partition_for(key).exists(key);
+	}
+	//@}
+
+	/**
+	 * Evict least recently used elements of each partition until there are
+	 * no more than it's share of max_size of them.
+	 * @param max_size
+	 * @param max_count maximum number of elements to remove from all the
+	 * 		partitions
+	 * @return number of elements removed
+	 */
+	size_t
+	shrink(size_t max_size, size_t max_count = std::numeric_limits< size_t >::max())
+	{
+		size_t removed = 0;
+		for (std::size_t i = 0; i < partitions_.size() && removed < max_count; ++i) {
+			removed += partitions_[i]->shrink(share(max_size, i), max_count - removed);
+		}
+		return removed;
+	}
+	/**
+	 * Remove elements that were not accessed for longer than age.
+	 * @param age
+	 * @param max_count maximum number of elements to remove from all the
+	 * 		partitions
+	 * @return number of elements removed
+	 */
+	size_t
+	expire(duration_type age, size_t max_count = std::numeric_limits< size_t >::max())
+	{
+		size_t removed = 0;
+		for (std::size_t i = 0; i < partitions_.size() && removed < max_count; ++i) {
+			removed += partitions_[i]->expire(age, max_count - removed);
+		}
+		return removed;
+	}
+	void
+	clear()
+	{
+		for (auto& p : partitions_) {
+			p->clear();
+		}
+	}
+	size_t
+	reclaim(size_t max_count = std::numeric_limits< size_t >::max())
+	{
+		size_t reclaimed = 0;
+		for (std::size_t i = 0; i < partitions_.size() && reclaimed < max_count; ++i) {
+			reclaimed += partitions_[i]->reclaim(max_count - reclaimed);
+		}
+		return reclaimed;
+	}
+	/**
+	 * Set capacity of the evicted keys lists, divided between the partitions
+	 */
+	void
+	set_ghost_capacity(size_t capacity)
+	{
+		for (std::size_t i = 0; i < partitions_.size(); ++i) {
+			partitions_[i]->set_ghost_capacity(share(capacity, i));
+		}
+	}
+	size_t
+	ghost_capacity() const
+	{
+		size_t capacity = 0;
+		for (auto const& p : partitions_) {
+			capacity += p->ghost_capacity();
+		}
+		return capacity;
+	}
+	/**
+	 * Mark the tail of the LRU list of each partition, the count is divided
+	 * between the partitions
+	 * @see lru_cache::mark_tail
+	 * @return number of elements marked
+	 */
+	size_t
+	mark_tail(size_t count)
+	{
+		size_t marked = 0;
+		for (std::size_t i = 0; i < partitions_.size(); ++i) {
+			marked += partitions_[i]->mark_tail(
+					count ? std::max< size_t >(share(count, i), 1) : 0);
+		}
+		return marked;
+	}
+	/**
+	 * Limit the number of elements admitted, divided between the partitions
+	 */
+	void
+	set_admission_limit(size_t max_size)
+	{
+		for (std::size_t i = 0; i < partitions_.size(); ++i) {
+			partitions_[i]->set_admission_limit(
+				max_size == std::numeric_limits< size_t >::max() ?
+						max_size : share(max_size, i));
+		}
+	}
+	/**
+	 * Statistics summed over the partitions
+	 */
+	cache_stats
+	stats() const
+	{
+		cache_stats res{ 0, 0, 0, 0, 0, 0, 0 };
+		for (auto const& p : partitions_) {
+			cache_stats s = p->stats();
+			res.hits				+= s.hits;
+			res.misses				+= s.misses;
+			res.ghost_hits			+= s.ghost_hits;
+			res.evictions			+= s.evictions;
+			res.unused_evictions	+= s.unused_evictions;
+			res.rejections			+= s.rejections;
+			res.tail_hits			+= s.tail_hits;
+		}
+		return res;
+	}
+	static size_t
+	entry_size()
+	{
+		return partition_type::entry_size();
+	}
+	size_t
+	memory_usage() const
+	{
+		size_t usage = 0;
+		for (auto const& p : partitions_) {
+			usage += p->memory_usage();
+		}
+		return usage;
+	}
+	void
+	set_access_recorder(access_recorder_ptr recorder)
+	{
+		for (auto& p : partitions_) {
+			p->set_access_recorder(recorder);
+		}
+	}
+	/**
+	 * Enable per-thread front cache of each partition
+	 * @see lru_cache::enable_front_cache
+	 */
+	void
+	enable_front_cache(std::size_t slots, std::uint64_t max_lag = 0,
+			std::uint32_t refresh_ms = 10)
+	{
+		for (auto& p : partitions_) {
+			p->enable_front_cache(slots, max_lag, refresh_ms);
+		}
+	}
+	void
+	disable_front_cache()
+	{
+		enable_front_cache(0);
+	}
+	bool
+	empty() const
+	{
+		return size() == 0;
+	}
+	/**
+	 * Number of valid elements in all the partitions. Doesn't lock the
+	 * partitions.
+	 */
+	size_t
+	size() const
+	{
+		size_t res = 0;
+		for (auto const& p : partitions_) {
+			res += p->size();
+		}
+		return res;
+	}
+
+	std::size_t
+	partition_count() const
+	{
+		return partitions_.size();
+	}
+	partition_type&
+	partition(std::size_t n)
+	{
+		return *partitions_[n];
+	}
+	partition_type const&
+	partition(std::size_t n) const
+	{
+		return *partitions_[n];
+	}
+	/**
+	 * Index of the partition holding the key
+	 */
+	std::size_t
+	partition_index(key_type const& key) const
+	{
+		std::uint64_t h = static_cast< std::uint64_t >(std::hash< key_type >()(key));
+		return static_cast< std::size_t >(
+				(h * 0x9e3779b97f4a7c15ULL >> 32) % partitions_.size());
+	}
+	/**
+	 * Share of a total size the partition gets
+	 */
+	size_t
+	share(size_t total, std::size_t n) const
+	{
+		size_t count = partitions_.size();
+		return total / count + (n < total % count ? 1 : 0);
+	}
+protected:
+	/**
+	 * Cache without partitions, for services that are never constructed
+	 * this way
+	 */
+	partitioned_lru_cache() {}
+
+	partition_type&
+	partition_for(key_type const& key)
+	{
+		return *partitions_[partition_index(key)];
+	}
+	partition_type const&
+	partition_for(key_type const& key) const
+	{
+		return *partitions_[partition_index(key)];
+	}
+private:
+	typedef std::unique_ptr< partition_type >	partition_ptr;
+	typedef std::function< key_type(value_type const&) >	get_key_function;
+
+	void
+	init(std::size_t partitions)
+	{
+		if (!partitions) {
+			throw std::logic_error("Partitioned cache needs at least one partition");
+		}
+		partitions_.resize(partitions);
+	}
+private:
+	std::vector< partition_ptr >	partitions_;
+	get_key_function				get_key_;
+};
+
+}  // namespace util
+}  // namespace tip
+
+#endif /* TIP_LRU_CACHE_PARTITIONED_LRU_CACHE_HPP_ */
@@ -0,0 +1,153 @@
+/*
+ * partitioned_lru_cache_service.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#ifndef TIP_LRU_CACHE_PARTITIONED_LRU_CACHE_SERVICE_HPP_
+#define TIP_LRU_CACHE_PARTITIONED_LRU_CACHE_SERVICE_HPP_
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <tip/lru-cache/partitioned_lru_cache.hpp>
+
+namespace tip {
+namespace lru {
+
+/**
+ * Partitioned LRU cache with periodic maintenance spread over the threads
+ * running the io_service. On each timer tick a sweep of every partition is
+ * posted as a separate handler, sweeps of a partition are serialized by
+ * the partition's strand. The timer is restarted when all the sweeps of
+ * the tick are complete.
+ */
+template < typename Value,
+		typename GetKey,
+		typename GetTime = boost::posix_time::ptime,
+		typename SetTime = void,
+		typename Locking = util::exclusive_locking >
+class partitioned_lru_cache_service : public boost::asio::detail::service_base<
+			partitioned_lru_cache_service<Value, GetKey, GetTime, SetTime, Locking>>,
+		public util::partitioned_lru_cache< Value, GetKey, GetTime, SetTime, Locking > {
+public:
+	typedef partitioned_lru_cache_service<
+			Value, GetKey, GetTime, SetTime, Locking > this_type;
+	typedef boost::asio::io_service io_service;
+	typedef boost::asio::detail::service_base< this_type > service_base;
+	typedef util::partitioned_lru_cache<
+			Value, GetKey, GetTime, SetTime, Locking > container_base;
+	typedef typename container_base::duration_type	duration_type;
+	typedef boost::asio::deadline_timer deadline_timer;
+	typedef deadline_timer::duration_type timer_iterval_type;
+	typedef io_service::strand strand_type;
+public:
+	//@{
+	/** @name Constructor required for compiling use_service template function */
+	partitioned_lru_cache_service( io_service& owner ) :
+			service_base(owner), container_base(),
+			timer_interval_(), max_age_(), max_size_(0),
+			timer_(owner, timer_interval_), pending_(0)
+	{
+		throw std::logic_error("LRU Cache service must be added manually to "
+				"io_service before it can be used");
+	}
+	//@}
+	/**
+	 * @param owner
+	 * @param timer_interval interval between maintenance ticks
+	 * @param max_age elements not accessed for longer are expired
+	 * @param partitions number of partitions
+	 * @param args arguments of the lru_cache constructor for the partitions
+	 */
+	template < typename ... Args >
+	partitioned_lru_cache_service( io_service& owner,
+				timer_iterval_type timer_interval,
+				duration_type max_age,
+				std::size_t partitions,
+				Args const& ... args ) :
+			service_base(owner), container_base(partitions, args ...),
+			timer_interval_(timer_interval), max_age_(max_age),
+			max_size_(std::numeric_limits< std::size_t >::max()),
+			timer_(owner, timer_interval_), pending_(0)
+	{
+		for (std::size_t i = 0; i < partitions; ++i) {
+			strands_.emplace_back(new strand_type(owner));
+		}
+		start_timer();
+	}
+	virtual ~partitioned_lru_cache_service() {}
+
+	/**
+	 * Limit the number of elements, the cache is shrunk to the size on each
+	 * timer tick
+	 */
+	void
+	set_max_size(std::size_t max_size)
+	{
+		max_size_.store(max_size, std::memory_order_relaxed);
+	}
+	std::size_t
+	max_size() const
+	{
+		return max_size_.load(std::memory_order_relaxed);
+	}
+private:
+	typedef std::unique_ptr< strand_type >	strand_ptr;
+
+	virtual void
+	shutdown_service()
+	{
+		timer_.cancel();
+		container_base::clear();
+		container_base::reclaim();
+	}
+	void
+	start_timer()
+	{
+		timer_.async_wait(
+				std::bind(&partitioned_lru_cache_service::timer_expired,
+						this, std::placeholders::_1));
+	}
+	void
+	timer_expired( boost::system::error_code const& ec)
+	{
+		if (ec == boost::asio::error::operation_aborted)
+			return;
+		pending_.store(strands_.size(), std::memory_order_relaxed);
+		for (std::size_t i = 0; i < strands_.size(); ++i) {
+			strands_[i]->post(
+					std::bind(&partitioned_lru_cache_service::sweep, this, i));
+		}
+	}
+	/**
+	 * Maintain a partition, the last sweep of a tick restarts the timer
+	 */
+	void
+	sweep(std::size_t n)
+	{
+		typename container_base::partition_type& p = container_base::partition(n);
+		p.expire(max_age_);
+		std::size_t max_size = max_size_.load(std::memory_order_relaxed);
+		if (max_size != std::numeric_limits< std::size_t >::max())
+			p.shrink(container_base::share(max_size, n));
+		if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			timer_.expires_at(timer_.expires_at() + timer_interval_);
+			start_timer();
+		}
+	}
+private:
+	timer_iterval_type			timer_interval_;
+	duration_type				max_age_;
+	std::atomic< std::size_t >	max_size_;
+	deadline_timer				timer_;
+	std::vector< strand_ptr >	strands_;
+	std::atomic< std::size_t >	pending_;
+};
+
+}  // namespace lru
+}  // namespace tip
+
+#endif /* TIP_LRU_CACHE_PARTITIONED_LRU_CACHE_SERVICE_HPP_ */
@@ -0,0 +1,95 @@
+/*
+ * access_trace_test.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#include <gtest/gtest.h>
+#include <cstdio>
+
+#include <tip/lru-cache/access_trace.hpp>
+
+TEST(AccessTrace, RecordAndRead)
+{
+	typedef tip::util::lru_cache<std::string, int>
+				str_cache_type;
+	using tip::util::access_event;
+	std::string file_name = "access_trace_test.trace";
+	{
+		str_cache_type cache;
+		cache.set_access_recorder(std::make_shared< tip::util::access_trace_writer >(
+				file_name, 4, 1, 16, 1));
+		cache.put(0, "zero");
+		cache.get(0);
+		EXPECT_THROW(cache.get(1), std::range_error);
+		cache.erase(0);
+		cache.put(2, "two");
+		cache.put(3, "three");
+	}
+	tip::util::access_trace_reader reader(file_name);
+	EXPECT_EQ(6, reader.header().written);
+	EXPECT_EQ(1, reader.header().sample_modulus);
+	auto records = reader.read();
+	ASSERT_EQ(4, records.size());
+	EXPECT_EQ(access_event::miss, static_cast< access_event >(records[0].event));
+	EXPECT_EQ(std::hash<int>()(1), records[0].key_hash);
+	EXPECT_EQ(access_event::erase, static_cast< access_event >(records[1].event));
+	EXPECT_EQ(access_event::put, static_cast< access_event >(records[2].event));
+	EXPECT_EQ(std::hash<int>()(2), records[2].key_hash);
+	EXPECT_EQ(std::hash<int>()(3), records[3].key_hash);
+	std::remove(file_name.c_str());
+}
+
+TEST(AccessTrace, Sampling)
+{
+	std::string file_name = "access_trace_sampling.trace";
+	{
+		tip::util::access_trace_writer writer(file_name, 1024, 4);
+		for (std::uint64_t i = 0; i < 1000; ++i) {
+			writer.record(i, tip::util::access_event::hit);
+		}
+	}
+	// Invalid arguments don't truncate an existing trace
+	EXPECT_THROW(tip::util::access_trace_writer(file_name, 0), std::logic_error);
+	EXPECT_THROW(tip::util::access_trace_writer(file_name, 1024, 0),
+			std::logic_error);
+	tip::util::access_trace_reader reader(file_name);
+	auto records = reader.read();
+	EXPECT_LT(150, records.size());
+	EXPECT_GT(350, records.size());
+	std::remove(file_name.c_str());
+}
+
+TEST(AccessTrace, WriteFailure)
+{
+	typedef tip::util::lru_cache<std::string, int>
+				str_cache_type;
+	auto writer = std::make_shared< tip::util::access_trace_writer >(
+			"/dev/full", 1024, 1, 2);
+	str_cache_type cache;
+	cache.set_access_recorder(writer);
+	EXPECT_NO_THROW(cache.put(1, "uno"));
+	EXPECT_FALSE(writer->flush());
+	EXPECT_TRUE(writer->failed());
+	EXPECT_NO_THROW(cache.put(2, "dos"));
+	EXPECT_NO_THROW(cache.put(3, "tres"));
+	EXPECT_NO_THROW(cache.erase(3));
+	EXPECT_EQ("uno", cache.get(1));
+	EXPECT_EQ(2, cache.size());
+}
+
+TEST(AccessTrace, DropWhenFull)
+{
+	std::string file_name = "access_trace_drop.trace";
+	{
+		tip::util::access_trace_writer writer(file_name, 1024, 1, 4, 1000);
+		for (std::uint64_t i = 0; i < 10; ++i) {
+			writer.record(i, tip::util::access_event::hit);
+		}
+		EXPECT_EQ(6, writer.dropped());
+	}
+	tip::util::access_trace_reader reader(file_name);
+	EXPECT_EQ(4, reader.read().size());
+	std::remove(file_name.c_str());
+}
@@ -7,6 +7,7 @@
 
 #include <gtest/gtest.h>
 #include <thread>
+#include <array>
 
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <tip/lru-cache/lru_cache.hpp>
@@ -107,3 +108,437 @@ TEST(LruContainer, KeyExtractor)
 	cache.expire(std::chrono::milliseconds(10));
 	EXPECT_TRUE(cache.empty());
 }
+
+TEST(LruContainer, FrontCache)
+{
+	typedef tip::util::lru_cache<std::string, int>
+				str_cache_type;
+	str_cache_type cache;
+	cache.enable_front_cache(16);
+	cache.put(0, "zero");
+	cache.put(1, "one");
+	EXPECT_EQ("zero", cache.get(0));
+	EXPECT_EQ("zero", cache.get(0));
+	cache.put(0, "null");
+	EXPECT_EQ("null", cache.get(0));
+	cache.erase(0);
+	EXPECT_THROW(cache.get(0), std::range_error);
+	EXPECT_EQ("one", cache.get(1));
+
+	std::thread t([&]() {
+		EXPECT_EQ("one", cache.get(1));
+		EXPECT_EQ("one", cache.get(1));
+	});
+	t.join();
+
+	cache.clear();
+	EXPECT_THROW(cache.get(1), std::range_error);
+
+	// Allow front cache entries to lag one mutation behind
+	cache.enable_front_cache(16, 1);
+	cache.put(2, "two");
+	EXPECT_EQ("two", cache.get(2));
+	cache.put(2, "deux");
+	EXPECT_EQ("two", cache.get(2));
+	cache.put(3, "three");
+	EXPECT_EQ("deux", cache.get(2));
+}
+
+TEST(LruContainer, Generations)
+{
+	typedef tip::util::lru_cache<std::string, int>
+				str_cache_type;
+	str_cache_type cache;
+	for (int i = 0; i < 10; ++i) {
+		cache.put(i, std::to_string(i));
+	}
+	EXPECT_EQ(10, cache.size());
+	cache.clear();
+	EXPECT_TRUE(cache.empty());
+	EXPECT_EQ(0, cache.size());
+	EXPECT_FALSE(cache.exists(0));
+	EXPECT_THROW(cache.get(0), std::range_error);
+
+	cache.put(0, "zero");
+	cache.put(1, "one");
+	EXPECT_EQ(2, cache.size());
+	EXPECT_TRUE(cache.exists(0));
+	EXPECT_EQ("one", cache.get(1));
+	EXPECT_FALSE(cache.exists(5));
+	EXPECT_EQ(5, cache.reclaim());
+	EXPECT_EQ(0, cache.reclaim());
+
+	cache.clear();
+	cache.put(2, "two");
+	cache.shrink(10);
+	EXPECT_EQ(1, cache.size());
+	EXPECT_EQ(0, cache.reclaim());
+	EXPECT_EQ("two", cache.get(2));
+}
+
+TEST(LruContainer, ReclaimInBatches)
+{
+	typedef tip::util::lru_cache<std::string, int>
+				str_cache_type;
+	str_cache_type cache;
+	for (int i = 0; i < 5000; ++i) {
+		cache.put(i, std::to_string(i));
+	}
+	cache.clear();
+	cache.put(0, "zero");
+	// The put replaced stale zero and reclaimed two more stale elements,
+	// the rest are reclaimed over several lock acquisitions
+	EXPECT_EQ(1500, cache.expire(std::chrono::hours(1), 1500));
+	EXPECT_EQ(3497, cache.shrink(1));
+	EXPECT_EQ(0, cache.reclaim());
+	EXPECT_EQ(1, cache.size());
+	EXPECT_EQ("zero", cache.get(0));
+}
+
+TEST(LruContainer, GhostHits)
+{
+	typedef tip::util::lru_cache<std::string, int>
+				str_cache_type;
+	str_cache_type cache;
+	cache.set_ghost_capacity(3);
+	for (int i = 0; i < 10; ++i) {
+		cache.put(i, std::to_string(i));
+	}
+	cache.shrink(5);
+	EXPECT_EQ(5, cache.stats().evictions);
+	// 0 and 1 are out of the ghost list
+	EXPECT_THROW(cache.get(0), std::range_error);
+	EXPECT_THROW(cache.get(1), std::range_error);
+	EXPECT_EQ(0, cache.stats().ghost_hits);
+	EXPECT_THROW(cache.get(2), std::range_error);
+	EXPECT_THROW(cache.get(4), std::range_error);
+	EXPECT_EQ(2, cache.stats().ghost_hits);
+	// A ghost hit removes the key from the ghost list
+	EXPECT_THROW(cache.get(4), std::range_error);
+	EXPECT_EQ(2, cache.stats().ghost_hits);
+	EXPECT_EQ("9", cache.get(9));
+
+	auto stats = cache.stats();
+	EXPECT_EQ(1, stats.hits);
+	EXPECT_EQ(5, stats.misses);
+}
+
+namespace {
+
+struct timed_value {
+	int id;
+	std::chrono::high_resolution_clock::time_point accessed;
+};
+
+}  // namespace
+
+TEST(LruContainer, TailHits)
+{
+	typedef tip::util::lru_cache<std::string, int>
+				str_cache_type;
+	str_cache_type cache;
+	for (int i = 0; i < 10; ++i) {
+		cache.put(i, std::to_string(i));
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+	EXPECT_EQ(3, cache.mark_tail(3));
+	// 0, 1 and 2 are in the tail
+	EXPECT_EQ("9", cache.get(9));
+	EXPECT_EQ(0, cache.stats().tail_hits);
+	EXPECT_EQ("1", cache.get(1));
+	EXPECT_EQ("1", cache.get(1));
+	EXPECT_EQ("2", cache.get(2));
+	EXPECT_EQ(2, cache.stats().tail_hits);
+	EXPECT_EQ(0, cache.mark_tail(0));
+	EXPECT_EQ("0", cache.get(0));
+	EXPECT_EQ(2, cache.stats().tail_hits);
+	EXPECT_EQ(10, cache.mark_tail(20));
+}
+
+TEST(LruContainer, TimeIntrusive)
+{
+	typedef std::chrono::high_resolution_clock::time_point time_point;
+	typedef tip::util::lru_cache< timed_value,
+			std::function< int(timed_value const&) >,
+			std::function< time_point(timed_value const&) >,
+			std::function< void(timed_value&, time_point) > > cache_type;
+	cache_type cache(
+			[](timed_value const& v) { return v.id; },
+			[](timed_value const& v) { return v.accessed; },
+			[](timed_value& v, time_point tm) { v.accessed = tm; });
+	for (int i = 0; i < 5; ++i) {
+		cache.put(timed_value{ i, time_point{} });
+	}
+	EXPECT_NE(time_point{}, cache.get(3).accessed);
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	cache.get(1);
+	cache.expire(std::chrono::milliseconds(25));
+	EXPECT_EQ(1, cache.size());
+	EXPECT_TRUE(cache.exists(1));
+}
+
+TEST(LruContainer, EntrySize)
+{
+	typedef std::array< char, 16 > value_type;
+	typedef tip::util::lru_cache< value_type, int > cache_type;
+	// Key and value are stored once, index entry and list node hold
+	// pointers, hash, access time and generation
+	EXPECT_GE(sizeof(int) + sizeof(value_type) + 12 * sizeof(void*),
+			cache_type::entry_size());
+	cache_type cache;
+	cache.put(1, value_type{});
+	cache.put(2, value_type{});
+	// Index buckets are preallocated
+	EXPECT_LE(2 * cache_type::entry_size(), cache.memory_usage());
+	EXPECT_GE(2 * cache_type::entry_size() + 16 * sizeof(void*),
+			cache.memory_usage());
+}
+
+TEST(LruContainer, EvictWithoutKeyExtraction)
+{
+	typedef tip::util::lru_cache<int, std::function< int(int) >>
+			int_cache_type;
+	int extracted = 0;
+	int_cache_type cache([&extracted](int a) { ++extracted; return a; } );
+	for (int i = 0; i < 10000; ++i) {
+		cache.put(i);
+	}
+	EXPECT_EQ(10000, cache.size());
+	int before = extracted;
+	cache.shrink(100);
+	cache.clear();
+	cache.reclaim();
+	EXPECT_EQ(before, extracted);
+	EXPECT_TRUE(cache.empty());
+
+	for (int i = 0; i < 1000; ++i) {
+		cache.put(i);
+	}
+	cache.shrink(10);
+	for (int i = 0; i < 990; ++i) {
+		EXPECT_FALSE(cache.exists(i));
+	}
+	for (int i = 990; i < 1000; ++i) {
+		EXPECT_EQ(i, cache.get(i));
+	}
+}
+
+TEST(LruContainer, SharedLocking)
+{
+	typedef tip::util::lru_cache<int, int,
+			std::chrono::high_resolution_clock::time_point, void,
+			tip::util::shared_locking > int_cache_type;
+	int_cache_type cache;
+	for (int i = 0; i < 100; ++i) {
+		cache.put(i, i * 10);
+	}
+	EXPECT_EQ(100, cache.size());
+	// peek doesn't move the element to the head of the LRU list
+	EXPECT_EQ(0, cache.peek(0));
+	EXPECT_THROW(cache.peek(100), std::range_error);
+	cache.shrink(99);
+	EXPECT_FALSE(cache.exists(0));
+
+	std::vector< std::thread > readers;
+	std::atomic< int > found(0);
+	for (int t = 0; t < 4; ++t) {
+		readers.emplace_back([&]() {
+			for (int n = 0; n < 100; ++n) {
+				for (int i = 1; i < 100; ++i) {
+					if (cache.exists(i) && cache.peek(i) == i * 10)
+						++found;
+				}
+			}
+		});
+	}
+	for (int i = 100; i < 1000; ++i) {
+		cache.put(i, i * 10);
+		cache.get(i - 50);
+	}
+	for (auto& t : readers) {
+		t.join();
+	}
+	EXPECT_EQ(4 * 100 * 99, found);
+	EXPECT_EQ(999, cache.size());
+	cache.clear();
+	EXPECT_TRUE(cache.empty());
+	EXPECT_EQ(0, cache.size());
+}
+
+TEST(LruContainer, AdmissionLimit)
+{
+	typedef tip::util::lru_cache< std::string, int > cache_type;
+	cache_type cache;
+	for (int i = 0; i < 5; ++i) {
+		EXPECT_TRUE(cache.put(i, std::to_string(i)));
+	}
+	cache.set_admission_limit(5);
+	EXPECT_FALSE(cache.put(5, "five"));
+	EXPECT_FALSE(cache.exists(5));
+	// Existing keys are still updated
+	EXPECT_TRUE(cache.put(0, "zero"));
+	EXPECT_EQ("zero", cache.get(0));
+	EXPECT_EQ(5, cache.size());
+	EXPECT_EQ(1, cache.stats().rejections);
+
+	cache.erase(1);
+	EXPECT_TRUE(cache.put(5, "five"));
+	cache.set_admission_limit(std::numeric_limits< std::size_t >::max());
+	EXPECT_TRUE(cache.put(6, "six"));
+	EXPECT_EQ(6, cache.size());
+}
+
+TEST(LruContainer, ComputeInPlace)
+{
+	typedef tip::util::lru_cache< int, std::string > cache_type;
+	cache_type cache;
+	cache.enable_front_cache(16);
+	auto increment = [](int& v) { ++v; };
+
+	EXPECT_FALSE(cache.compute_if_present("a", increment));
+	EXPECT_FALSE(cache.exists("a"));
+	EXPECT_TRUE(cache.compute("a", increment));
+	EXPECT_EQ(1, cache.get("a"));
+	EXPECT_TRUE(cache.compute("a", increment));
+	EXPECT_TRUE(cache.compute_if_present("a", increment));
+	// Front cache doesn't return the value before update
+	EXPECT_EQ(3, cache.get("a"));
+
+	auto add = [](int& stored, int const& v) { stored += v; };
+	EXPECT_TRUE(cache.merge("b", 10, add));
+	EXPECT_EQ(10, cache.peek("b"));
+	EXPECT_TRUE(cache.merge("b", 5, add));
+	EXPECT_EQ(15, cache.peek("b"));
+	EXPECT_EQ(2, cache.size());
+
+	// Updates count as accesses
+	cache.put("c", 0);
+	cache.compute_if_present("a", increment);
+	cache.shrink(2);
+	EXPECT_TRUE(cache.exists("a"));
+	EXPECT_FALSE(cache.exists("b"));
+
+	cache.set_admission_limit(2);
+	EXPECT_FALSE(cache.compute("d", increment));
+	EXPECT_FALSE(cache.merge("d", 1, add));
+	EXPECT_TRUE(cache.compute("c", increment));
+	EXPECT_EQ(1, cache.peek("c"));
+
+	cache.clear();
+	EXPECT_FALSE(cache.compute_if_present("a", increment));
+	cache.set_admission_limit(std::numeric_limits< std::size_t >::max());
+	EXPECT_TRUE(cache.compute("a", increment));
+	EXPECT_EQ(1, cache.peek("a"));
+	EXPECT_EQ(1, cache.size());
+}
+
+TEST(LruContainer, ComputeConcurrent)
+{
+	typedef tip::util::lru_cache< int, int > cache_type;
+	cache_type cache;
+	std::vector< std::thread > threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&cache]() {
+			for (int i = 0; i < 1000; ++i) {
+				cache.compute(i % 10, [](int& v) { ++v; });
+			}
+		});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	for (int i = 0; i < 10; ++i) {
+		EXPECT_EQ(400, cache.peek(i));
+	}
+}
+
+TEST(LruContainer, FrontCacheRecency)
+{
+	typedef tip::util::lru_cache<std::string, int>
+				str_cache_type;
+	str_cache_type cache;
+	cache.enable_front_cache(16, 100, 1);
+	cache.put(0, "zero");
+	EXPECT_EQ("zero", cache.get(0));
+	for (int i = 1; i < 5; ++i) {
+		cache.put(i, std::to_string(i));
+	}
+	// The hot key is read only through the front cache
+	for (int i = 0; i < 15; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		EXPECT_EQ("zero", cache.get(0));
+	}
+	cache.shrink(1);
+	EXPECT_TRUE(cache.exists(0));
+	EXPECT_EQ(4, cache.stats().unused_evictions);
+
+	cache.put(1, "one");
+	for (int i = 0; i < 15; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		EXPECT_EQ("zero", cache.get(0));
+	}
+	cache.expire(std::chrono::milliseconds(20));
+	EXPECT_TRUE(cache.exists(0));
+	EXPECT_FALSE(cache.exists(1));
+}
+
+TEST(LruContainer, FrontCacheHits)
+{
+	typedef tip::util::lru_cache<std::string, int>
+				str_cache_type;
+	str_cache_type cache;
+	cache.enable_front_cache(16, 0, 1000000);
+	cache.put(0, "zero");
+	EXPECT_EQ("zero", cache.get(0));
+	EXPECT_EQ(1, cache.stats().hits);
+	for (int i = 0; i < 3; ++i) {
+		EXPECT_EQ("zero", cache.get(0));
+	}
+	// Front cache hits are kept in the slot
+	EXPECT_EQ(1, cache.stats().hits);
+	cache.put(1, "one");
+	// and are added when the slot is refilled
+	EXPECT_EQ("zero", cache.get(0));
+	EXPECT_EQ(5, cache.stats().hits);
+}
+
+TEST(LruContainer, FrontCacheBatch)
+{
+	typedef tip::util::lru_cache<std::string, int>
+				str_cache_type;
+	str_cache_type cache;
+	cache.enable_front_cache(16, 100, 1000000);
+	cache.put(0, "zero");
+	cache.put(1, "one");
+	EXPECT_EQ("zero", cache.get(0));
+	EXPECT_EQ("one", cache.get(1));
+	for (int i = 2; i < 5; ++i) {
+		cache.put(i, std::to_string(i));
+	}
+	// Front cache hits are queued
+	EXPECT_EQ("zero", cache.get(0));
+	EXPECT_EQ("one", cache.get(1));
+	EXPECT_EQ(2, cache.stats().hits);
+	// and are propagated together when the thread locks the container
+	EXPECT_THROW(cache.get(9), std::range_error);
+	EXPECT_EQ(4, cache.stats().hits);
+	cache.shrink(2);
+	EXPECT_TRUE(cache.exists(0));
+	EXPECT_TRUE(cache.exists(1));
+}
+
+TEST(LruContainer, ComputeThrows)
+{
+	typedef tip::util::lru_cache< int, std::string > cache_type;
+	cache_type cache;
+	auto fail = [](int&) { throw std::runtime_error("fail"); };
+	EXPECT_THROW(cache.compute("a", fail), std::runtime_error);
+	EXPECT_FALSE(cache.exists("a"));
+	EXPECT_EQ(0, cache.size());
+
+	cache.put("b", 1);
+	EXPECT_THROW(cache.compute("b", fail), std::runtime_error);
+	EXPECT_THROW(cache.compute_if_present("b", fail), std::runtime_error);
+	EXPECT_EQ(1, cache.peek("b"));
+	EXPECT_EQ(1, cache.size());
+}
@@ -7,6 +7,7 @@
 
 #include <gtest/gtest.h>
 #include <tip/lru-cache/lru_cache_service.hpp>
+#include <tip/lru-cache/lru_cache_registry.hpp>
 
 TEST(CacheService, KeyValue)
 {
@@ -84,3 +85,90 @@ TEST(CacheService, KeyExtractor)
 		EXPECT_FALSE(cache.exists(0));
 	}
 }
+
+TEST(CacheService, AutoSizing)
+{
+	typedef tip::lru::lru_cache_service< std::string, int > cache_type;
+	boost::asio::io_service io_service;
+	auto budget = std::make_shared< tip::lru::memory_budget >(1024 * 1024);
+	boost::asio::add_service(io_service,
+			new cache_type( io_service,
+					boost::posix_time::seconds(10),
+					boost::posix_time::seconds(10)));
+	cache_type& cache = boost::asio::use_service<cache_type>(io_service);
+	for (int i = 0; i < 10; ++i) {
+		cache.put(i, std::to_string(i));
+	}
+	cache.enable_auto_sizing(5, 100, budget);
+	EXPECT_EQ(5, cache.target_size());
+	EXPECT_EQ(5, cache.size());
+	EXPECT_EQ(5, cache.ghost_capacity());
+	EXPECT_EQ(5 * cache_type::entry_size(), budget->used());
+}
+
+TEST(CacheRegistry, BoundedMaintenance)
+{
+	typedef tip::util::lru_cache< std::string, int > cache_type;
+	typedef std::shared_ptr< cache_type > cache_ptr;
+	boost::asio::io_service io_service;
+	EXPECT_THROW(boost::asio::use_service<tip::lru::lru_cache_registry>(io_service),
+			std::logic_error);
+	auto budget = std::make_shared< tip::lru::memory_budget >(1024 * 1024);
+	boost::asio::add_service(io_service,
+			new tip::lru::lru_cache_registry(io_service,
+					boost::posix_time::seconds(10), budget, 10));
+	tip::lru::lru_cache_registry& registry =
+			boost::asio::use_service<tip::lru::lru_cache_registry>(io_service);
+
+	cache_ptr first = std::make_shared< cache_type >();
+	cache_ptr second = std::make_shared< cache_type >();
+	for (int i = 0; i < 20; ++i) {
+		first->put(i, std::to_string(i));
+		second->put(i, std::to_string(i));
+	}
+	auto id = registry.add(first, std::chrono::hours(1), 5, 100);
+	registry.add(second, std::chrono::hours(1), 5, 100);
+	EXPECT_EQ(2, registry.size());
+	EXPECT_EQ(10 * cache_type::entry_size(), budget->used());
+
+	// Work per tick is limited, the next tick continues with the same cache
+	EXPECT_EQ(10, registry.maintain());
+	EXPECT_EQ(10, first->size());
+	EXPECT_EQ(20, second->size());
+	EXPECT_EQ(10, registry.maintain());
+	EXPECT_EQ(5, first->size());
+	EXPECT_EQ(15, second->size());
+	EXPECT_EQ(10, registry.maintain());
+	EXPECT_EQ(5, second->size());
+	EXPECT_EQ(0, registry.maintain());
+
+	registry.remove(id);
+	EXPECT_EQ(1, registry.size());
+	EXPECT_EQ(5 * cache_type::entry_size(), budget->used());
+}
+
+TEST(CacheRegistry, DefaultSizes)
+{
+	typedef tip::util::lru_cache< std::string, int > cache_type;
+	boost::asio::io_service io_service;
+	boost::asio::add_service(io_service,
+			new tip::lru::lru_cache_registry(io_service,
+					boost::posix_time::seconds(10)));
+	tip::lru::lru_cache_registry& registry =
+			boost::asio::use_service<tip::lru::lru_cache_registry>(io_service);
+	EXPECT_FALSE(registry.budget());
+
+	auto unlimited = std::make_shared< cache_type >();
+	auto limited = std::make_shared< cache_type >();
+	for (int i = 0; i < 100; ++i) {
+		unlimited->put(i, std::to_string(i));
+		limited->put(i, std::to_string(i));
+	}
+	registry.add(unlimited, std::chrono::hours(1));
+	registry.add(limited, std::chrono::hours(1), 0, 50);
+	EXPECT_EQ(50, registry.maintain());
+	EXPECT_EQ(100, unlimited->size());
+	EXPECT_EQ(50, limited->size());
+	EXPECT_EQ(0, registry.maintain());
+	EXPECT_EQ(0, unlimited->ghost_capacity());
+}
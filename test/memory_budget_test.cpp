@@ -0,0 +1,101 @@
+/*
+ * memory_budget_test.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#include <gtest/gtest.h>
+#include <tip/lru-cache/memory_budget.hpp>
+
+TEST(MemoryBudget, GrowWithinBudget)
+{
+	tip::lru::memory_budget budget(1000, 10);
+	auto a = budget.add(10, 110, 5);
+	EXPECT_EQ(10, budget.target(a));
+	EXPECT_EQ(10, budget.step(a));
+	EXPECT_EQ(50, budget.used());
+	// No ghost hits - no growth
+	EXPECT_EQ(10, budget.update(a, 0));
+	EXPECT_EQ(20, budget.update(a, 1));
+	for (int i = 0; i < 20; ++i) {
+		budget.update(a, 1);
+	}
+	EXPECT_EQ(110, budget.target(a));
+	EXPECT_EQ(550, budget.used());
+}
+
+TEST(MemoryBudget, MoveToHigherUtility)
+{
+	tip::lru::memory_budget budget(1000, 10);
+	auto a = budget.add(0, 100, 10);
+	auto b = budget.add(0, 100, 10);
+	for (int i = 0; i < 10; ++i) {
+		budget.update(a, 0.5);
+	}
+	EXPECT_EQ(100, budget.target(a));
+	EXPECT_EQ(0, budget.target(b));
+	// b gains more hits per element, memory flows from a to b
+	for (int i = 0; i < 5; ++i) {
+		budget.update(b, 2);
+		budget.update(a, 0.5);
+	}
+	EXPECT_EQ(50, budget.target(a));
+	EXPECT_EQ(50, budget.target(b));
+	EXPECT_EQ(1000, budget.used());
+
+	budget.set_bytes(600);
+	EXPECT_EQ(10, budget.target(a));
+	EXPECT_EQ(50, budget.target(b));
+	budget.remove(a);
+	EXPECT_EQ(500, budget.used());
+}
+
+TEST(MemoryBudget, RankDonorsByCost)
+{
+	tip::lru::memory_budget budget(1000, 10);
+	auto a = budget.add(0, 100, 10);
+	auto b = budget.add(0, 100, 10);
+	for (int i = 0; i < 10; ++i) {
+		budget.update(a, 1, 0);
+	}
+	EXPECT_EQ(100, budget.target(a));
+	// a fits, gains nothing by growing but loses hits by shrinking, b
+	// gains less than a would lose
+	for (int i = 0; i < 5; ++i) {
+		budget.update(a, 0, 1);
+		budget.update(b, 0.5, 0);
+	}
+	EXPECT_EQ(100, budget.target(a));
+	EXPECT_EQ(0, budget.target(b));
+	// a's tail is not hit, memory flows to b
+	for (int i = 0; i < 5; ++i) {
+		budget.update(a, 0, 0.1);
+		budget.update(b, 0.5, 0.5);
+	}
+	EXPECT_EQ(50, budget.target(a));
+	EXPECT_EQ(50, budget.target(b));
+}
+
+TEST(MemoryBudget, UnlimitedNoOverflow)
+{
+	std::size_t const unlimited = std::numeric_limits< std::size_t >::max();
+	tip::lru::memory_budget budget(unlimited);
+	auto a = budget.add(0, unlimited, 72);
+	auto b = budget.add(0, unlimited, 72);
+	EXPECT_EQ(65536, budget.step(a));
+	for (int i = 0; i < 3; ++i) {
+		budget.update(a, 2);
+		budget.update(b, 1);
+	}
+	EXPECT_EQ(3 * 65536, budget.target(a));
+	EXPECT_EQ(3 * 65536, budget.target(b));
+	EXPECT_EQ(6 * 65536 * 72, budget.used());
+
+	// Huge targets saturate instead of wrapping
+	tip::lru::memory_budget huge(unlimited, 1, unlimited);
+	auto c = huge.add(unlimited / 2, unlimited, 72);
+	huge.add(0, 100, 72);
+	EXPECT_EQ(unlimited, huge.used());
+	EXPECT_EQ(unlimited / 2, huge.target(c));
+}
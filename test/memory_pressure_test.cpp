@@ -0,0 +1,99 @@
+/*
+ * memory_pressure_test.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#include <gtest/gtest.h>
+#include <tip/lru-cache/lru_cache_service.hpp>
+
+#include <cstdio>
+
+TEST(MemoryPressure, CgroupProbe)
+{
+	{
+		std::ofstream current("memory.current");
+		current << "900\n";
+		std::ofstream max("memory.max");
+		max << "1000\n";
+	}
+	tip::lru::memory_reading reading{ 0, 0 };
+	EXPECT_TRUE(tip::lru::cgroup_memory_probe(".")(reading));
+	EXPECT_EQ(900, reading.current);
+	EXPECT_EQ(1000, reading.limit);
+	{
+		std::ofstream max("memory.max");
+		max << "max\n";
+	}
+	EXPECT_FALSE(tip::lru::cgroup_memory_probe(".")(reading));
+	EXPECT_FALSE(tip::lru::cgroup_memory_probe("no-such-cgroup")(reading));
+	std::remove("memory.current");
+	std::remove("memory.max");
+}
+
+TEST(MemoryPressure, Watermarks)
+{
+	using tip::lru::memory_pressure_action;
+	std::size_t usage = 50;
+	tip::lru::memory_pressure_monitor monitor(
+		[&usage](tip::lru::memory_reading& r)
+		{ r.current = usage; r.limit = 100; return true; },
+		tip::lru::memory_pressure_options(), nullptr);
+	tip::lru::memory_pressure_event event;
+	EXPECT_FALSE(monitor.check(event));
+	usage = 95;
+	EXPECT_TRUE(monitor.check(event));
+	EXPECT_EQ(memory_pressure_action::shrink, event.action);
+	EXPECT_EQ(95, event.reading.current);
+	usage = 85;
+	EXPECT_FALSE(monitor.check(event));
+	EXPECT_TRUE(monitor.under_pressure());
+	usage = 70;
+	EXPECT_TRUE(monitor.check(event));
+	EXPECT_EQ(memory_pressure_action::resume, event.action);
+	EXPECT_FALSE(monitor.check(event));
+
+	EXPECT_EQ(90, monitor.shrink_target(100));
+	EXPECT_EQ(4, monitor.shrink_target(5));
+	EXPECT_EQ(0, monitor.shrink_target(0));
+}
+
+TEST(MemoryPressure, CacheService)
+{
+	using tip::lru::memory_pressure_action;
+	typedef tip::lru::lru_cache_service< std::string, int > cache_type;
+	boost::asio::io_service io_service;
+	boost::asio::add_service(io_service,
+			new cache_type( io_service,
+					boost::posix_time::milliseconds(1),
+					boost::posix_time::seconds(10)));
+	cache_type& cache = boost::asio::use_service<cache_type>(io_service);
+	for (int i = 0; i < 20; ++i) {
+		cache.put(i, std::to_string(i));
+	}
+	std::size_t usage = 95;
+	std::vector< tip::lru::memory_pressure_event > events;
+	tip::lru::memory_pressure_options opts;
+	opts.shrink_percent = 50;
+	cache.enable_memory_pressure(
+		[&usage](tip::lru::memory_reading& r)
+		{ r.current = usage; r.limit = 100; return true; },
+		opts,
+		[&events](tip::lru::memory_pressure_event const& e)
+		{ events.push_back(e); });
+
+	io_service.run_one();
+	ASSERT_EQ(1, events.size());
+	EXPECT_EQ(memory_pressure_action::shrink, events.back().action);
+	EXPECT_EQ(10, events.back().removed);
+	EXPECT_EQ(10, cache.size());
+	EXPECT_FALSE(cache.put(100, "hundred"));
+
+	usage = 50;
+	io_service.run_one();
+	ASSERT_EQ(2, events.size());
+	EXPECT_EQ(memory_pressure_action::resume, events.back().action);
+	EXPECT_TRUE(cache.put(100, "hundred"));
+	EXPECT_EQ(11, cache.size());
+}
@@ -0,0 +1,119 @@
+/*
+ * partitioned_cache_test.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#include <gtest/gtest.h>
+#include <tip/lru-cache/partitioned_lru_cache_service.hpp>
+
+#include <thread>
+
+TEST(PartitionedCache, KeyValue)
+{
+	typedef tip::util::partitioned_lru_cache< std::string, int > cache_type;
+	EXPECT_THROW(cache_type(0), std::logic_error);
+	cache_type cache(4);
+	EXPECT_EQ(4, cache.partition_count());
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_TRUE(cache.put(i, std::to_string(i)));
+	}
+	EXPECT_EQ(100, cache.size());
+	std::size_t total = 0;
+	for (std::size_t i = 0; i < cache.partition_count(); ++i) {
+		EXPECT_LT(0, cache.partition(i).size());
+		total += cache.partition(i).size();
+	}
+	EXPECT_EQ(100, total);
+	EXPECT_TRUE(cache.partition(cache.partition_index(42)).exists(42));
+	EXPECT_EQ("42", cache.get(42));
+	EXPECT_THROW(cache.get(100), std::range_error);
+	cache.erase(42);
+	EXPECT_FALSE(cache.exists(42));
+	EXPECT_EQ(1, cache.stats().hits);
+	EXPECT_EQ(1, cache.stats().misses);
+
+	cache.shrink(10);
+	for (std::size_t i = 0; i < cache.partition_count(); ++i) {
+		EXPECT_GE(cache.share(10, i), cache.partition(i).size());
+	}
+	EXPECT_EQ(3, cache.share(10, 0));
+	EXPECT_EQ(2, cache.share(10, 3));
+	cache.clear();
+	EXPECT_TRUE(cache.empty());
+}
+
+TEST(PartitionedCache, KeyExtractor)
+{
+	typedef tip::util::partitioned_lru_cache<int, std::function< int(int) >>
+			int_cache_type;
+	int_cache_type cache(3, [](int a) { return a; } );
+	for (int i = 0; i < 10; ++i) {
+		EXPECT_TRUE(cache.put(i));
+	}
+	EXPECT_EQ(10, cache.size());
+	EXPECT_EQ(5, cache.get(5));
+}
+
+TEST(PartitionedCache, FrontCache)
+{
+	typedef tip::util::partitioned_lru_cache< std::string, int > cache_type;
+	cache_type cache(4);
+	cache.enable_front_cache(16, 0, 1000000);
+	cache.put(0, "zero");
+	EXPECT_EQ("zero", cache.get(0));
+	EXPECT_EQ("zero", cache.get(0));
+	// The front cache hit is not propagated before the refresh interval
+	EXPECT_EQ(1, cache.stats().hits);
+	cache.erase(0);
+	EXPECT_THROW(cache.get(0), std::range_error);
+	EXPECT_EQ(2, cache.stats().hits);
+}
+
+TEST(PartitionedCache, ParallelMaintenance)
+{
+	typedef tip::lru::partitioned_lru_cache_service< std::string, int > cache_type;
+	boost::asio::io_service io_service;
+	EXPECT_THROW(boost::asio::use_service<cache_type>(io_service), std::logic_error);
+	boost::asio::add_service(io_service,
+			new cache_type( io_service,
+					boost::posix_time::milliseconds(1),
+					boost::posix_time::seconds(10), 8));
+	cache_type& cache = boost::asio::use_service<cache_type>(io_service);
+	for (int i = 0; i < 1000; ++i) {
+		cache.put(i, std::to_string(i));
+	}
+	cache.set_max_size(100);
+
+	std::vector< std::thread > threads;
+	for (int i = 0; i < 4; ++i) {
+		threads.emplace_back([&io_service](){ io_service.run(); });
+	}
+	for (int i = 0; i < 1000 && cache.size() > 100; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	io_service.stop();
+	for (auto& t : threads) {
+		t.join();
+	}
+	EXPECT_GE(100, cache.size());
+	for (std::size_t i = 0; i < cache.partition_count(); ++i) {
+		EXPECT_GE(cache.share(100, i), cache.partition(i).size());
+	}
+}
+
+TEST(PartitionedCache, ComputeInPlace)
+{
+	typedef tip::util::partitioned_lru_cache< int, int > cache_type;
+	cache_type cache(4);
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_TRUE(cache.compute(i % 10, [](int& v) { ++v; }));
+	}
+	EXPECT_EQ(10, cache.size());
+	EXPECT_EQ(10, cache.get(3));
+	EXPECT_TRUE(cache.compute_if_present(3, [](int& v) { v = 0; }));
+	EXPECT_FALSE(cache.compute_if_present(10, [](int& v) { v = 0; }));
+	EXPECT_TRUE(cache.merge(3, 5, [](int& s, int const& v) { s += v; }));
+	EXPECT_EQ(5, cache.peek(3));
+}
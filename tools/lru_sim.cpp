@@ -0,0 +1,184 @@
+/*
+ * lru_sim.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: zmij
+ */
+
+#include <tip/lru-cache/access_trace.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <unordered_set>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+typedef tip::util::access_trace_reader::record_list	record_list;
+typedef tip::util::lru_cache< char, std::uint64_t >		sim_cache_type;
+
+struct sim_options {
+	std::string		trace_file;
+	std::size_t		threads		= std::thread::hardware_concurrency();
+	std::size_t		steps		= 16;
+	std::uint64_t	min_capacity = 0;
+	std::uint64_t	max_capacity = 0;
+	bool			fill		= true;
+};
+
+struct sim_result {
+	std::uint64_t	capacity;
+	std::uint64_t	gets;
+	std::uint64_t	hits;
+};
+
+void
+usage(char const* name)
+{
+	std::cerr << "Usage: " << name << " [options] <trace-file>\n"
+		<< "Replay an access trace against LRU caches of different capacities\n"
+		<< "Options:\n"
+		<< "  -j <threads>   number of simulation threads\n"
+		<< "  -s <steps>     number of capacities to simulate (default 16)\n"
+		<< "  -m <capacity>  minimal capacity (default max / 256)\n"
+		<< "  -M <capacity>  maximal capacity (default number of keys in trace)\n"
+		<< "  --no-fill      don't put a key to cache after a miss\n";
+}
+
+bool
+parse_options(int argc, char* argv[], sim_options& opts)
+{
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if (arg == "-j" && has_value) {
+			opts.threads = std::strtoull(argv[++i], nullptr, 10);
+		} else if (arg == "-s" && has_value) {
+			opts.steps = std::strtoull(argv[++i], nullptr, 10);
+		} else if (arg == "-m" && has_value) {
+			opts.min_capacity = std::strtoull(argv[++i], nullptr, 10);
+		} else if (arg == "-M" && has_value) {
+			opts.max_capacity = std::strtoull(argv[++i], nullptr, 10);
+		} else if (arg == "--no-fill") {
+			opts.fill = false;
+		} else if (!arg.empty() && arg[0] != '-' && opts.trace_file.empty()) {
+			opts.trace_file = arg;
+		} else {
+			return false;
+		}
+	}
+	if (!opts.threads)
+		opts.threads = 1;
+	if (!opts.steps)
+		opts.steps = 1;
+	return !opts.trace_file.empty();
+}
+
+/**
+ * Replay the trace against a cache of the given capacity.
+ * The capacity is already scaled by the trace sample rate.
+ */
+sim_result
+simulate(record_list const& records, std::uint64_t capacity,
+		std::uint64_t sim_capacity, bool fill)
+{
+	using tip::util::access_event;
+	sim_cache_type cache;
+	sim_result res{ capacity, 0, 0 };
+	for (auto const& rec : records) {
+		switch (static_cast< access_event >(rec.event)) {
+			case access_event::hit:
+			case access_event::miss:
+				++res.gets;
+				if (cache.exists(rec.key_hash)) {
+					cache.get(rec.key_hash);
+					++res.hits;
+				} else if (fill) {
+					cache.put(rec.key_hash, 0);
+					cache.shrink(sim_capacity);
+				}
+				break;
+			case access_event::put:
+				cache.put(rec.key_hash, 0);
+				cache.shrink(sim_capacity);
+				break;
+			case access_event::erase:
+				cache.erase(rec.key_hash);
+				break;
+			default:
+				break;
+		}
+	}
+	return res;
+}
+
+}  // namespace
+
+int
+main(int argc, char* argv[])
+try {
+	sim_options opts;
+	if (!parse_options(argc, argv, opts)) {
+		usage(argv[0]);
+		return 1;
+	}
+	tip::util::access_trace_reader reader(opts.trace_file);
+	record_list records = reader.read();
+	std::uint64_t modulus = reader.header().sample_modulus;
+
+	std::unordered_set< std::uint64_t > keys;
+	for (auto const& rec : records) {
+		keys.insert(rec.key_hash);
+	}
+	std::uint64_t max_cap = opts.max_capacity ?
+			opts.max_capacity : std::max< std::uint64_t >(keys.size() * modulus, 1);
+	std::uint64_t min_cap = opts.min_capacity ?
+			opts.min_capacity : std::max< std::uint64_t >(max_cap / 256, 1);
+	if (min_cap > max_cap)
+		std::swap(min_cap, max_cap);
+
+	std::vector< std::uint64_t > capacities;
+	for (std::size_t i = 0; i < opts.steps; ++i) {
+		double f = opts.steps > 1 ? double(i) / (opts.steps - 1) : 1.0;
+		std::uint64_t cap = static_cast< std::uint64_t >(std::llround(
+				min_cap * std::pow(double(max_cap) / min_cap, f)));
+		if (capacities.empty() || capacities.back() != cap)
+			capacities.push_back(cap);
+	}
+
+	std::vector< sim_result > results(capacities.size());
+	std::atomic< std::size_t > next(0);
+	std::vector< std::thread > threads;
+	for (std::size_t t = 0; t < std::min(opts.threads, capacities.size()); ++t) {
+		threads.emplace_back([&]() {
+			for (std::size_t i = next++; i < capacities.size(); i = next++) {
+				std::uint64_t sim_cap =
+						std::max< std::uint64_t >(capacities[i] / modulus, 1);
+				results[i] = simulate(records, capacities[i], sim_cap, opts.fill);
+			}
+		});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	std::cout << "# trace " << opts.trace_file << ": " << records.size()
+			<< " records, " << keys.size() << " keys, sample modulus "
+			<< modulus << "\n"
+			<< std::setw(16) << "capacity"
+			<< std::setw(12) << "hit_ratio"
+			<< std::setw(12) << "miss_ratio" << "\n";
+	for (auto const& res : results) {
+		double hit_ratio = res.gets ? double(res.hits) / res.gets : 0.0;
+		std::cout << std::setw(16) << res.capacity << std::fixed
+				<< std::setprecision(4)
+				<< std::setw(12) << hit_ratio
+				<< std::setw(12) << (res.gets ? 1.0 - hit_ratio : 0.0) << "\n";
+	}
+	return 0;
+} catch (std::exception const& e) {
+	std::cerr << e.what() << "\n";
+	return 1;
+}